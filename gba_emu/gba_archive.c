@@ -0,0 +1,526 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include "libretro.h"
+#include <string.h>
+#include <strings.h>
+
+/*
+ * Read-only streams over .gz and .zip ROMs.
+ * The decompressed bytes are produced on demand while the core reads,
+ * so the ROM is never held twice in memory.
+ */
+
+#define GBA_ARCHIVE_METHOD_STORED 0
+#define GBA_ARCHIVE_METHOD_DEFLATE 8
+
+#define GBA_ZIP_LOCAL_SIG 0x04034b50
+#define GBA_ZIP_CENTRAL_SIG 0x02014b50
+#define GBA_ZIP_EOCD_SIG 0x06054b50
+#define GBA_ZIP_EOCD_SIZE 22
+#define GBA_ZIP_COMMENT_MAX 0xFFFF
+
+/* Largest GBA cartridge, anything bigger is a corrupted header */
+#define GBA_ARCHIVE_SIZE_MAX (32 * 1024 * 1024)
+
+typedef struct {
+    uint32_t data_offset;
+    uint32_t comp_size;
+    uint32_t size;
+    uint32_t crc32;
+    uint8_t method;
+} gba_archive_entry_t;
+
+struct gba_archive_s {
+    lv_fs_file_t file;
+    gba_archive_entry_t entry;
+    gba_inflate_t* inflate;
+
+    /* Position the decoder has reached and position requested by seek */
+    uint64_t pos;
+    uint64_t seek_pos;
+    uint32_t comp_remain;
+
+    uint32_t crc32;
+    bool crc_valid;
+    bool corrupt;
+
+    uint64_t decode_time;
+    uint64_t decode_bytes;
+};
+
+static inline uint16_t gba_archive_le16(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t gba_archive_le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool gba_archive_read_at(lv_fs_file_t* file, uint32_t pos, void* buf, uint32_t len)
+{
+    uint32_t br;
+    if (lv_fs_seek(file, pos, LV_FS_SEEK_SET) != LV_FS_RES_OK
+        || lv_fs_read(file, buf, len, &br) != LV_FS_RES_OK) {
+        return false;
+    }
+    return br == len;
+}
+
+static bool gba_archive_get_file_size(lv_fs_file_t* file, uint32_t* size)
+{
+    if (lv_fs_seek(file, 0, LV_FS_SEEK_END) != LV_FS_RES_OK) {
+        return false;
+    }
+    return lv_fs_tell(file, size) == LV_FS_RES_OK;
+}
+
+static bool gba_archive_probe_gz(lv_fs_file_t* file, gba_archive_entry_t* entry)
+{
+    uint32_t file_size;
+    if (!gba_archive_get_file_size(file, &file_size) || file_size < 18) {
+        return false;
+    }
+
+    uint8_t header[10];
+    if (!gba_archive_read_at(file, 0, header, sizeof(header))) {
+        return false;
+    }
+
+    if (header[0] != 0x1F || header[1] != 0x8B || header[2] != GBA_ARCHIVE_METHOD_DEFLATE) {
+        LV_LOG_WARN("not a gzip file");
+        return false;
+    }
+
+    uint8_t flags = header[3];
+    uint32_t pos = sizeof(header);
+    uint8_t buf[8];
+
+    /* FEXTRA */
+    if (flags & 0x04) {
+        if (!gba_archive_read_at(file, pos, buf, 2)) {
+            return false;
+        }
+        pos += 2 + gba_archive_le16(buf);
+    }
+
+    /* FNAME and FCOMMENT are zero terminated */
+    for (int flag = 0x08; flag <= 0x10; flag <<= 1) {
+        if (!(flags & flag)) {
+            continue;
+        }
+        do {
+            if (!gba_archive_read_at(file, pos++, buf, 1)) {
+                return false;
+            }
+        } while (buf[0] != '\0');
+    }
+
+    /* FHCRC */
+    if (flags & 0x02) {
+        pos += 2;
+    }
+
+    /* The trailer holds the CRC32 and the size modulo 2^32 */
+    if (pos + 8 > file_size || !gba_archive_read_at(file, file_size - 8, buf, 8)) {
+        return false;
+    }
+
+    entry->method = GBA_ARCHIVE_METHOD_DEFLATE;
+    entry->data_offset = pos;
+    entry->comp_size = file_size - 8 - pos;
+    entry->crc32 = gba_archive_le32(buf);
+    entry->size = gba_archive_le32(buf + 4);
+    return true;
+}
+
+static bool gba_archive_probe_zip(lv_fs_file_t* file, gba_archive_entry_t* entry)
+{
+    uint32_t file_size;
+    if (!gba_archive_get_file_size(file, &file_size) || file_size < GBA_ZIP_EOCD_SIZE) {
+        return false;
+    }
+
+    /* Scan backwards for the end of central directory record, it may be followed by a comment */
+    uint32_t search_size = LV_MIN(file_size, GBA_ZIP_EOCD_SIZE + GBA_ZIP_COMMENT_MAX);
+    uint8_t* search_buf = gba_mem_alloc(LV_GBA_MEM_TAG_IO, search_size);
+    LV_ASSERT_MALLOC(search_buf);
+    if (!search_buf) {
+        return false;
+    }
+
+    uint32_t search_start = file_size - search_size;
+    int32_t eocd = -1;
+    if (gba_archive_read_at(file, search_start, search_buf, search_size)) {
+        for (int32_t i = search_size - GBA_ZIP_EOCD_SIZE; i >= 0; i--) {
+            if (gba_archive_le32(search_buf + i) == GBA_ZIP_EOCD_SIG) {
+                eocd = i;
+                break;
+            }
+        }
+    }
+
+    if (eocd < 0) {
+        gba_mem_free(search_buf);
+        LV_LOG_WARN("zip end of central directory not found");
+        return false;
+    }
+
+    uint16_t entry_num = gba_archive_le16(search_buf + eocd + 10);
+    uint32_t cd_offset = gba_archive_le32(search_buf + eocd + 16);
+    gba_mem_free(search_buf);
+
+    /* Pick the first .gba entry, or the first file if there is none */
+    bool found = false;
+    bool found_gba = false;
+    uint32_t local_offset = 0;
+    uint32_t pos = cd_offset;
+
+    for (uint16_t i = 0; i < entry_num && !found_gba; i++) {
+        uint8_t header[46];
+        if (!gba_archive_read_at(file, pos, header, sizeof(header))
+            || gba_archive_le32(header) != GBA_ZIP_CENTRAL_SIG) {
+            LV_LOG_WARN("zip central directory corrupted");
+            return false;
+        }
+
+        uint16_t name_len = gba_archive_le16(header + 28);
+        uint16_t extra_len = gba_archive_le16(header + 30);
+        uint16_t comment_len = gba_archive_le16(header + 32);
+
+        char name[256];
+        uint32_t read_len = LV_MIN(name_len, sizeof(name) - 1);
+        if (!gba_archive_read_at(file, pos + sizeof(header), name, read_len)) {
+            return false;
+        }
+        name[read_len] = '\0';
+
+        uint16_t method = gba_archive_le16(header + 10);
+        bool is_dir = name_len > 0 && name[read_len - 1] == '/';
+        bool is_gba = strcasecmp(lv_fs_get_ext(name), "gba") == 0;
+
+        if (!is_dir && (method == GBA_ARCHIVE_METHOD_STORED || method == GBA_ARCHIVE_METHOD_DEFLATE)
+            && (!found || is_gba)) {
+            found = true;
+            found_gba = is_gba;
+            entry->method = method;
+            entry->crc32 = gba_archive_le32(header + 16);
+            entry->comp_size = gba_archive_le32(header + 20);
+            entry->size = gba_archive_le32(header + 24);
+            local_offset = gba_archive_le32(header + 42);
+        }
+
+        pos += sizeof(header) + name_len + extra_len + comment_len;
+    }
+
+    if (!found) {
+        LV_LOG_WARN("no usable entry in zip");
+        return false;
+    }
+
+    /* The local header may carry a different extra field than the central one */
+    uint8_t local[30];
+    if (!gba_archive_read_at(file, local_offset, local, sizeof(local))
+        || gba_archive_le32(local) != GBA_ZIP_LOCAL_SIG) {
+        LV_LOG_WARN("zip local header corrupted");
+        return false;
+    }
+
+    entry->data_offset = local_offset + sizeof(local) + gba_archive_le16(local + 26) + gba_archive_le16(local + 28);
+    return entry->data_offset + entry->comp_size <= file_size;
+}
+
+static bool gba_archive_probe(lv_fs_file_t* file, const char* path, gba_archive_entry_t* entry)
+{
+    const char* ext = lv_fs_get_ext(path);
+    bool ret = false;
+
+    if (strcasecmp(ext, "gz") == 0) {
+        ret = gba_archive_probe_gz(file, entry);
+    } else if (strcasecmp(ext, "zip") == 0) {
+        ret = gba_archive_probe_zip(file, entry);
+    }
+
+    if (ret && entry->size > GBA_ARCHIVE_SIZE_MAX) {
+        LV_LOG_WARN("uncompressed size %" LV_PRIu32 " too large", entry->size);
+        return false;
+    }
+
+    return ret;
+}
+
+static size_t gba_archive_inflate_read_cb(void* user_data, uint8_t* buf, size_t len)
+{
+    gba_archive_t* archive = user_data;
+
+    if (len > archive->comp_remain) {
+        len = archive->comp_remain;
+    }
+
+    uint32_t br = 0;
+    if (len == 0 || lv_fs_read(&archive->file, buf, len, &br) != LV_FS_RES_OK) {
+        return 0;
+    }
+
+    archive->comp_remain -= br;
+    return br;
+}
+
+static bool gba_archive_rewind(gba_archive_t* archive)
+{
+    if (lv_fs_seek(&archive->file, archive->entry.data_offset, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        return false;
+    }
+
+    archive->pos = 0;
+    archive->comp_remain = archive->entry.comp_size;
+    archive->crc32 = 0;
+    archive->crc_valid = true;
+
+    if (archive->inflate) {
+        gba_inflate_reset(archive->inflate);
+    }
+    return true;
+}
+
+static int64_t gba_archive_decode(gba_archive_t* archive, void* buf, uint64_t len)
+{
+    uint64_t remain = archive->entry.size - archive->pos;
+    if (len > remain) {
+        len = remain;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    uint64_t start = gba_tick_us_get();
+    int64_t ret;
+
+    if (archive->inflate) {
+        ret = gba_inflate_read(archive->inflate, buf, len);
+    } else {
+        ret = gba_archive_inflate_read_cb(archive, buf, len);
+    }
+
+    archive->decode_time += gba_tick_us_get() - start;
+
+    if (ret < 0) {
+        LV_LOG_ERROR("decompress failed at %" LV_PRIu32, (uint32_t)archive->pos);
+        return -1;
+    }
+
+    if (archive->crc_valid) {
+        archive->crc32 = gba_crc32(archive->crc32, buf, ret);
+    }
+
+    archive->pos += ret;
+    archive->decode_bytes += ret;
+
+    /* A corrupt ROM must not boot: every later read fails too */
+    if (archive->crc_valid && archive->pos == archive->entry.size && archive->crc32 != archive->entry.crc32) {
+        LV_LOG_ERROR("CRC mismatch: 0x%08" LV_PRIx32 " != 0x%08" LV_PRIx32, archive->crc32, archive->entry.crc32);
+        archive->corrupt = true;
+        return -1;
+    }
+
+    return ret;
+}
+
+static bool gba_archive_sync_pos(gba_archive_t* archive)
+{
+    if (archive->seek_pos == archive->pos) {
+        return true;
+    }
+
+    if (archive->seek_pos < archive->pos && !gba_archive_rewind(archive)) {
+        return false;
+    }
+
+    /* Bytes skipped forward are decoded and dropped, the CRC no longer covers the whole entry */
+    uint8_t skip_buf[1024];
+    while (archive->pos < archive->seek_pos) {
+        uint64_t n = LV_MIN(archive->seek_pos - archive->pos, sizeof(skip_buf));
+        archive->crc_valid = false;
+        if (gba_archive_decode(archive, skip_buf, n) <= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool gba_archive_is_supported(const char* path)
+{
+    const char* ext = lv_fs_get_ext(path);
+    return strcasecmp(ext, "gz") == 0 || strcasecmp(ext, "zip") == 0;
+}
+
+bool gba_archive_get_size(const char* path, size_t* size)
+{
+    lv_fs_file_t file;
+    lv_fs_res_t res = lv_fs_open(&file, path, LV_FS_MODE_RD);
+    if (res != LV_FS_RES_OK) {
+        LV_LOG_ERROR("open %s failed: %d", path, res);
+        return false;
+    }
+
+    gba_archive_entry_t entry;
+    bool ret = gba_archive_probe(&file, path, &entry);
+    lv_fs_close(&file);
+
+    if (!ret) {
+        LV_LOG_ERROR("unsupported archive: %s", path);
+        return false;
+    }
+
+    *size = entry.size;
+    return true;
+}
+
+gba_archive_t* gba_archive_open(const char* path)
+{
+    gba_archive_t* archive = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_IO, sizeof(gba_archive_t));
+    LV_ASSERT_MALLOC(archive);
+    if (!archive) {
+        return NULL;
+    }
+
+    if (lv_fs_open(&archive->file, path, LV_FS_MODE_RD) != LV_FS_RES_OK) {
+        gba_mem_free(archive);
+        return NULL;
+    }
+
+    if (!gba_archive_probe(&archive->file, path, &archive->entry)) {
+        goto failed;
+    }
+
+    if (archive->entry.method == GBA_ARCHIVE_METHOD_DEFLATE) {
+        archive->inflate = gba_inflate_create(gba_archive_inflate_read_cb, archive);
+        if (!archive->inflate) {
+            goto failed;
+        }
+    }
+
+    if (!gba_archive_rewind(archive)) {
+        goto failed;
+    }
+
+    return archive;
+
+failed:
+    gba_archive_close(archive);
+    return NULL;
+}
+
+void gba_archive_close(gba_archive_t* archive)
+{
+    if (archive->decode_bytes > 0) {
+        uint64_t time = LV_MAX(archive->decode_time, 1);
+        LV_LOG_USER("ROM: decompressed %" LV_PRIu32 " bytes in %" LV_PRIu32 " ms, %" LV_PRIu32 " KB/s",
+            (uint32_t)archive->decode_bytes,
+            (uint32_t)(archive->decode_time / 1000),
+            (uint32_t)(archive->decode_bytes * 1000000 / time / 1024));
+    }
+
+    if (archive->inflate) {
+        gba_inflate_delete(archive->inflate);
+    }
+
+    lv_fs_close(&archive->file);
+    gba_mem_free(archive);
+}
+
+int64_t gba_archive_read(gba_archive_t* archive, void* buf, uint64_t len)
+{
+    if (archive->corrupt) {
+        return -1;
+    }
+
+    /* Past the end: nothing to read, no need to decode up to there */
+    if (archive->seek_pos >= archive->entry.size) {
+        return 0;
+    }
+
+    if (!gba_archive_sync_pos(archive)) {
+        return -1;
+    }
+
+    uint8_t* dst = buf;
+    uint64_t total = 0;
+
+    while (total < len) {
+        int64_t ret = gba_archive_decode(archive, dst + total, len - total);
+        if (ret < 0) {
+            return total > 0 && !archive->corrupt ? (int64_t)total : -1;
+        }
+
+        if (ret == 0) {
+            break;
+        }
+
+        total += ret;
+    }
+
+    archive->seek_pos = archive->pos;
+    return total;
+}
+
+int64_t gba_archive_seek(gba_archive_t* archive, int64_t offset, int seek_position)
+{
+    int64_t base;
+
+    switch (seek_position) {
+    case RETRO_VFS_SEEK_POSITION_START:
+        base = 0;
+        break;
+    case RETRO_VFS_SEEK_POSITION_CURRENT:
+        base = archive->seek_pos;
+        break;
+    case RETRO_VFS_SEEK_POSITION_END:
+        base = archive->entry.size;
+        break;
+    default:
+        return -1;
+    }
+
+    if (base + offset < 0) {
+        return -1;
+    }
+
+    /* Seeking is lazy, the decoder only moves when data is read */
+    archive->seek_pos = base + offset;
+    return 0;
+}
+
+int64_t gba_archive_tell(gba_archive_t* archive)
+{
+    return archive->seek_pos;
+}
+
+int64_t gba_archive_size(gba_archive_t* archive)
+{
+    return archive->entry.size;
+}
@@ -0,0 +1,214 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+
+#ifndef GBA_ARENA_USE_MMAP
+#define GBA_ARENA_USE_MMAP 1
+#endif
+
+/* Address space only: pages are backed when the core touches them */
+#ifndef GBA_ARENA_RESERVE_SIZE
+#define GBA_ARENA_RESERVE_SIZE (64 * 1024 * 1024)
+#endif
+
+/* Ask for transparent huge pages, the interpreter hits these regions every cycle */
+#ifndef GBA_ARENA_USE_HUGEPAGE
+#define GBA_ARENA_USE_HUGEPAGE 1
+#endif
+
+#define GBA_ARENA_PAGE_SIZE 4096
+#define GBA_ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define GBA_ARENA_CACHE_LINE 64
+
+#if GBA_ARENA_USE_MMAP
+#include <sys/mman.h>
+#endif
+
+/*
+ * Bump allocator for the large regions the core allocates once per game
+ * (ROM, work RAM, VRAM, video buffer). They stay out of the LVGL heap, sit
+ * back to back in one reservation that is reused by every launch, and are
+ * dropped together by gba_arena_reset().
+ */
+typedef struct {
+    uint8_t* base;
+    size_t top;
+    size_t peak;
+    size_t used; /* Accounted to the core tag */
+    uint32_t live_num;
+    bool reserved;
+} gba_arena_t;
+
+static gba_arena_t g_arena;
+
+bool gba_arena_init(void)
+{
+    gba_arena_t* arena = &g_arena;
+
+    if (arena->base) {
+        return true;
+    }
+
+#if GBA_ARENA_USE_MMAP
+    /* Tried once, a failure keeps the per block allocations */
+    if (arena->reserved) {
+        return false;
+    }
+    arena->reserved = true;
+
+    /* One extra huge page so that the range can be trimmed to a 2 MB boundary */
+    size_t len = GBA_ARENA_RESERVE_SIZE + GBA_ARENA_HUGE_PAGE_SIZE;
+    uint8_t* map = mmap(NULL, len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (map == MAP_FAILED) {
+        LV_LOG_WARN("arena reserve failed, core buffers use the LVGL heap");
+        return false;
+    }
+
+    uint8_t* base = (uint8_t*)(((uintptr_t)map + GBA_ARENA_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(GBA_ARENA_HUGE_PAGE_SIZE - 1));
+    size_t head = base - map;
+    if (head > 0) {
+        munmap(map, head);
+    }
+    munmap(base + GBA_ARENA_RESERVE_SIZE, GBA_ARENA_HUGE_PAGE_SIZE - head);
+
+#if GBA_ARENA_USE_HUGEPAGE && defined(MADV_HUGEPAGE)
+    /* Only a hint: THP may be disabled, or no huge page free at fault time */
+    if (madvise(base, GBA_ARENA_RESERVE_SIZE, MADV_HUGEPAGE) != 0) {
+        LV_LOG_WARN("MADV_HUGEPAGE not supported, arena uses 4 KB pages");
+    }
+#endif
+
+    arena->base = base;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void* gba_arena_alloc(size_t size, size_t boundary)
+{
+    gba_arena_t* arena = &g_arena;
+
+    if (!arena->base) {
+        return NULL;
+    }
+
+    /*
+     * A ROM sized region starts on a huge page, other large regions on their
+     * own page and the rest on a cache line. The small ones pack together
+     * into the huge page that follows.
+     */
+    size_t align = GBA_ARENA_CACHE_LINE;
+    if (size >= GBA_ARENA_HUGE_PAGE_SIZE) {
+        align = GBA_ARENA_HUGE_PAGE_SIZE;
+    } else if (size >= GBA_ARENA_PAGE_SIZE) {
+        align = GBA_ARENA_PAGE_SIZE;
+    }
+
+    if (boundary > align) {
+        align = boundary;
+    }
+
+    size_t offset = (arena->top + align - 1) & ~(align - 1);
+    if (offset > GBA_ARENA_RESERVE_SIZE || size > GBA_ARENA_RESERVE_SIZE - offset) {
+        LV_LOG_WARN("arena full, %" LV_PRIu32 " bytes from the LVGL heap", (uint32_t)size);
+        return NULL;
+    }
+
+    arena->top = offset + size;
+    if (arena->top > arena->peak) {
+        arena->peak = arena->top;
+    }
+
+    arena->live_num++;
+    arena->used += size;
+    gba_mem_track(LV_GBA_MEM_TAG_CORE, size);
+    return arena->base + offset;
+}
+
+bool gba_arena_free(void* ptr)
+{
+    gba_arena_t* arena = &g_arena;
+    uint8_t* p = ptr;
+
+    if (!arena->base || p < arena->base || p >= arena->base + GBA_ARENA_RESERVE_SIZE) {
+        return false;
+    }
+
+    /* Blocks are not reused one by one, the space comes back once all of them are gone */
+    if (arena->live_num > 0 && --arena->live_num == 0) {
+        gba_mem_track(LV_GBA_MEM_TAG_CORE, -(ptrdiff_t)arena->used);
+        arena->used = 0;
+        arena->top = 0;
+    }
+
+    return true;
+}
+
+void gba_arena_report(void)
+{
+    gba_arena_t* arena = &g_arena;
+
+    if (!arena->base) {
+        return;
+    }
+
+#if GBA_ARENA_USE_MMAP
+    size_t huge_kb = gba_smaps_get_kb(arena->base, GBA_ARENA_RESERVE_SIZE, "AnonHugePages");
+    size_t rss_kb = gba_smaps_get_kb(arena->base, GBA_ARENA_RESERVE_SIZE, "Rss");
+
+    LV_LOG_USER("arena: %" LV_PRIu32 " KB used, %" LV_PRIu32 " KB resident, %" LV_PRIu32 " huge pages",
+        (uint32_t)(arena->top / 1024), (uint32_t)rss_kb,
+        (uint32_t)(huge_kb * 1024 / GBA_ARENA_HUGE_PAGE_SIZE));
+#endif
+}
+
+void gba_arena_reset(void)
+{
+    gba_arena_t* arena = &g_arena;
+
+    if (!arena->base) {
+        return;
+    }
+
+    if (arena->live_num > 0) {
+        LV_LOG_WARN("arena reset with %" LV_PRIu32 " live blocks", arena->live_num);
+    }
+
+    LV_LOG_USER("arena peak: %" LV_PRIu32 " KB", (uint32_t)(arena->peak / 1024));
+
+#if GBA_ARENA_USE_MMAP
+    /* Give the pages back but keep the range for the next game */
+    size_t len = (arena->peak + GBA_ARENA_PAGE_SIZE - 1) & ~(size_t)(GBA_ARENA_PAGE_SIZE - 1);
+    if (len > 0 && madvise(arena->base, len, MADV_DONTNEED) != 0) {
+        LV_LOG_WARN("arena madvise failed");
+    }
+#endif
+
+    gba_mem_track(LV_GBA_MEM_TAG_CORE, -(ptrdiff_t)arena->used);
+    arena->used = 0;
+    arena->top = 0;
+    arena->peak = 0;
+    arena->live_num = 0;
+}
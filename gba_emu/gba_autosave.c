@@ -0,0 +1,151 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include "libretro.h"
+
+/* Check the save RAM about once per second */
+#define GBA_AUTOSAVE_CHECK_FRAMES 60
+
+struct gba_autosave_s {
+    gba_worker_job_t job;
+    uint8_t* snapshot;
+    size_t size;
+    uint32_t frame_cnt;
+    volatile bool write_ok;
+    bool write_pending;
+    bool retry;
+    char path[256];
+};
+
+static void gba_autosave_job_cb(void* user_data)
+{
+    gba_autosave_t* autosave = user_data;
+    autosave->write_ok = gba_fs_write_file_atomic(autosave->path, autosave->snapshot, autosave->size);
+}
+
+static void gba_autosave_check_result(gba_autosave_t* autosave)
+{
+    if (!autosave->write_pending) {
+        return;
+    }
+
+    autosave->write_pending = false;
+
+    if (autosave->write_ok) {
+        LV_LOG_USER("Auto saved to %s", autosave->path);
+    } else {
+        LV_LOG_ERROR("Auto save to %s failed", autosave->path);
+        autosave->retry = true;
+    }
+}
+
+void gba_autosave_init(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+
+    size_t size = retro_get_memory_size(RETRO_MEMORY_SAVE_RAM);
+    const void* data = retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
+
+    if (size == 0 || data == NULL) {
+        return;
+    }
+
+    gba_autosave_t* autosave = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, sizeof(gba_autosave_t));
+    LV_ASSERT_MALLOC(autosave);
+    lv_memzero(autosave, sizeof(gba_autosave_t));
+
+    autosave->snapshot = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, size);
+    LV_ASSERT_MALLOC(autosave->snapshot);
+
+    /* The save RAM was just loaded from storage, use it as the clean reference */
+    lv_memcpy(autosave->snapshot, data, size);
+    autosave->size = size;
+
+    char save_path[256];
+    gba_retro_get_save_path(save_path, sizeof(save_path), ctx->rom_path);
+    gba_fs_get_native_path(autosave->path, sizeof(autosave->path), save_path);
+
+    gba_worker_job_init(&autosave->job, gba_autosave_job_cb, autosave);
+    ctx->autosave = autosave;
+}
+
+void gba_autosave_deinit(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_autosave_t* autosave = ctx->autosave;
+
+    if (!autosave) {
+        return;
+    }
+
+    gba_worker_wait(&autosave->job);
+    gba_autosave_check_result(autosave);
+
+    gba_mem_free(autosave->snapshot);
+    gba_mem_free(autosave);
+    ctx->autosave = NULL;
+}
+
+void gba_autosave_wait(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_autosave_t* autosave = ctx->autosave;
+
+    if (!autosave) {
+        return;
+    }
+
+    /* Both writers go through the same temp file, never let them overlap */
+    gba_worker_wait(&autosave->job);
+    gba_autosave_check_result(autosave);
+}
+
+void gba_autosave_update(gba_context_t* ctx)
+{
+    gba_autosave_t* autosave = ctx->autosave;
+
+    if (!autosave) {
+        return;
+    }
+
+    if (++autosave->frame_cnt < GBA_AUTOSAVE_CHECK_FRAMES) {
+        return;
+    }
+
+    /* Never wait for the storage, try again on the next period instead */
+    if (gba_worker_is_busy(&autosave->job)) {
+        return;
+    }
+
+    autosave->frame_cnt = 0;
+    gba_autosave_check_result(autosave);
+
+    const void* data = retro_get_memory_data(RETRO_MEMORY_SAVE_RAM);
+    if (!autosave->retry && lv_memcmp(autosave->snapshot, data, autosave->size) == 0) {
+        return;
+    }
+
+    lv_memcpy(autosave->snapshot, data, autosave->size);
+    autosave->write_pending = gba_worker_submit(&autosave->job);
+    autosave->retry = !autosave->write_pending;
+}
@@ -0,0 +1,363 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Headless batch runner: every ROM of a library runs for a fixed number of
+ * frames and the results are gathered into one report.
+ * The core is one per process, so the workers are forked. They take the
+ * next ROM from a counter in shared memory: a worker that is done early
+ * keeps taking ROMs, a slow ROM never holds back the others.
+ * A crashed worker only loses its current ROM and is replaced.
+ */
+
+#define GBA_BATCH_JOBS_MAX 64
+
+typedef enum {
+    GBA_BATCH_PENDING,
+    GBA_BATCH_RUNNING,
+    GBA_BATCH_DONE,
+    GBA_BATCH_FAILED,
+    GBA_BATCH_CRASHED,
+} gba_batch_status_t;
+
+typedef struct {
+    int32_t status;
+    pid_t pid;
+    uint32_t frames;
+    uint64_t total_us;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    uint32_t frame_crc32;
+} gba_batch_result_t;
+
+/* Shared by the runner and every worker */
+typedef struct {
+    uint32_t next;
+    uint32_t rom_num;
+    gba_batch_result_t results[];
+} gba_batch_shared_t;
+
+static const char* const g_batch_status_name[] = {
+    "pending",
+    "running",
+    "ok",
+    "failed",
+    "crashed",
+};
+
+static void gba_batch_scan_cb(gba_library_t* library, bool done, void* user_data)
+{
+    LV_UNUSED(library);
+    if (done) {
+        *(bool*)user_data = true;
+    }
+}
+
+static int gba_batch_time_cmp(const void* a, const void* b)
+{
+    uint32_t ta = *(const uint32_t*)a;
+    uint32_t tb = *(const uint32_t*)b;
+    return ta < tb ? -1 : ta > tb;
+}
+
+static uint32_t gba_batch_frame_crc32(const gba_context_t* ctx)
+{
+    if (!ctx->frame) {
+        return 0;
+    }
+
+    /* Visible pixels only, the stride padding is not part of the picture */
+    uint32_t crc = 0;
+    for (lv_coord_t y = 0; y < ctx->av_info.fb_height; y++) {
+        crc = gba_crc32(crc, ctx->frame + y * ctx->av_info.fb_stride, ctx->av_info.fb_width * sizeof(uint16_t));
+    }
+    return crc;
+}
+
+static bool gba_batch_run_rom(const char* path, uint32_t frames, uint32_t* times, gba_batch_result_t* result)
+{
+    char real_path[512];
+    lv_snprintf(real_path, sizeof(real_path), "/%s", path);
+
+    /* No view and no input: the frames are only timed and hashed */
+    gba_context_t ctx;
+    lv_memzero(&ctx, sizeof(ctx));
+    _lv_ll_init(&ctx.input_event_ll, sizeof(gba_input_event_t));
+    ctx.create_tick = gba_tick_us_get();
+
+    /* retro_init() sizes the ROM buffer, the ROM must be open first */
+    if (!gba_rom_open(real_path)) {
+        LV_LOG_ERROR("batch: open %s failed", real_path);
+        return false;
+    }
+
+    if (!gba_retro_init(&ctx)) {
+        gba_rom_close();
+        return false;
+    }
+
+    bool ok = false;
+    if (gba_retro_load_game(&ctx, real_path)) {
+        lv_strlcpy(ctx.rom_path, real_path, sizeof(ctx.rom_path));
+
+        for (uint32_t i = 0; i < frames; i++) {
+            uint64_t start = gba_tick_us_get();
+            gba_retro_run(&ctx);
+            times[i] = gba_tick_us_get() - start;
+            result->total_us += times[i];
+        }
+
+        qsort(times, frames, sizeof(uint32_t), gba_batch_time_cmp);
+        result->frames = frames;
+        result->p50_us = times[(frames - 1) * 50 / 100];
+        result->p90_us = times[(frames - 1) * 90 / 100];
+        result->p99_us = times[(frames - 1) * 99 / 100];
+        result->max_us = times[frames - 1];
+        result->frame_crc32 = gba_batch_frame_crc32(&ctx);
+        ok = true;
+    } else {
+        LV_LOG_ERROR("batch: load %s failed", real_path);
+    }
+
+    gba_retro_deinit(&ctx);
+    gba_rom_close();
+    return ok;
+}
+
+static void gba_batch_worker(gba_batch_shared_t* shared, char* const* paths, uint32_t frames)
+{
+    /* Stopped with the runner instead of inheriting the application handlers */
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+
+    uint32_t* times = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, frames * sizeof(uint32_t));
+    if (!times) {
+        _exit(EXIT_FAILURE);
+    }
+
+    while (1) {
+        uint32_t index = __atomic_fetch_add(&shared->next, 1, __ATOMIC_RELAXED);
+        if (index >= shared->rom_num) {
+            break;
+        }
+
+        gba_batch_result_t* result = &shared->results[index];
+        result->pid = getpid();
+        __atomic_store_n(&result->status, GBA_BATCH_RUNNING, __ATOMIC_RELEASE);
+        bool ok = gba_batch_run_rom(paths[index], frames, times, result);
+        __atomic_store_n(&result->status, ok ? GBA_BATCH_DONE : GBA_BATCH_FAILED, __ATOMIC_RELEASE);
+    }
+
+    _exit(EXIT_SUCCESS);
+}
+
+static pid_t gba_batch_spawn(gba_batch_shared_t* shared, char* const* paths, uint32_t frames)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        gba_batch_worker(shared, paths, frames);
+    } else if (pid < 0) {
+        perror("fork");
+    }
+    return pid;
+}
+
+static void gba_batch_mark_crashed(gba_batch_shared_t* shared, pid_t pid)
+{
+    for (uint32_t i = 0; i < shared->rom_num; i++) {
+        gba_batch_result_t* result = &shared->results[i];
+        if (result->pid == pid && __atomic_load_n(&result->status, __ATOMIC_ACQUIRE) == GBA_BATCH_RUNNING) {
+            result->status = GBA_BATCH_CRASHED;
+        }
+    }
+}
+
+static char** gba_batch_list_roms(const lv_gba_emu_batch_param_t* param, uint32_t* rom_num)
+{
+    if (param->file_path) {
+        char** paths = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, sizeof(char*));
+        if (paths) {
+            paths[0] = gba_mem_strdup(LV_GBA_MEM_TAG_EMU, param->file_path);
+            *rom_num = 1;
+        }
+        return paths;
+    }
+
+    /* Paths are kept as given, like the ones passed to lv_gba_emu_create() */
+    const char* dir = param->dir_path ? param->dir_path : ".";
+    char dir_path[512];
+    lv_snprintf(dir_path, sizeof(dir_path), dir[0] == '/' ? "%s" : "/%s", dir);
+
+    gba_library_t* library = gba_library_open(dir_path);
+    if (!library) {
+        return NULL;
+    }
+
+    /* The scan timer needs a tick, there is no display port in batch mode */
+    lv_tick_set_cb(gba_uptime_ms_get);
+
+    bool done = false;
+    if (!gba_library_refresh(library, gba_batch_scan_cb, &done)) {
+        gba_library_close(library);
+        return NULL;
+    }
+
+    while (!done) {
+        lv_timer_handler();
+        usleep(1000);
+    }
+
+    /* Listed in library order, so reports of two runs line up */
+    uint32_t count = gba_library_get_count(library);
+    char** paths = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, LV_MAX(count, 1) * sizeof(char*));
+    if (paths) {
+        for (uint32_t i = 0; i < count; i++) {
+            char path[512];
+            lv_snprintf(path, sizeof(path), "%s/%s", dir, gba_library_get_entry(library, i)->path);
+            paths[i] = gba_mem_strdup(LV_GBA_MEM_TAG_EMU, path);
+        }
+        *rom_num = count;
+    }
+
+    gba_library_close(library);
+    return paths;
+}
+
+static void gba_batch_write_report(FILE* fp, const gba_batch_shared_t* shared, char* const* paths, uint32_t wall_ms)
+{
+    uint64_t total_frames = 0;
+    uint32_t failed = 0;
+
+    fprintf(fp, "# rom\tstatus\tframes\tfps\tp50_us\tp90_us\tp99_us\tmax_us\tframe_crc32\n");
+
+    for (uint32_t i = 0; i < shared->rom_num; i++) {
+        const gba_batch_result_t* result = &shared->results[i];
+        double fps = result->total_us ? result->frames * 1000000.0 / result->total_us : 0;
+
+        fprintf(fp, "%s\t%s\t%" LV_PRIu32 "\t%.1f\t%" LV_PRIu32 "\t%" LV_PRIu32 "\t%" LV_PRIu32 "\t%" LV_PRIu32 "\t%08" LV_PRIx32 "\n",
+            paths[i], g_batch_status_name[result->status], result->frames, fps,
+            result->p50_us, result->p90_us, result->p99_us, result->max_us, result->frame_crc32);
+
+        total_frames += result->frames;
+        if (result->status != GBA_BATCH_DONE) {
+            failed++;
+        }
+    }
+
+    fprintf(fp, "# %" LV_PRIu32 " ROMs, %" LV_PRIu32 " failed, %" LV_PRIu32 " ms, %.1f frames/s in total\n",
+        shared->rom_num, failed, wall_ms, wall_ms ? total_frames * 1000.0 / wall_ms : 0);
+}
+
+int lv_gba_emu_run_batch(const lv_gba_emu_batch_param_t* param)
+{
+    LV_ASSERT_NULL(param);
+
+    if (param->frames == 0) {
+        return -1;
+    }
+
+    uint32_t rom_num = 0;
+    char** paths = gba_batch_list_roms(param, &rom_num);
+    if (!paths) {
+        LV_LOG_ERROR("batch: no ROM list");
+        return -1;
+    }
+
+    size_t shared_size = sizeof(gba_batch_shared_t) + rom_num * sizeof(gba_batch_result_t);
+    gba_batch_shared_t* shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) {
+        LV_LOG_ERROR("batch: shared memory failed");
+        return -1;
+    }
+    shared->rom_num = rom_num;
+
+    int jobs = param->jobs > 0 ? param->jobs : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    jobs = LV_CLAMP(1, jobs, LV_MIN(GBA_BATCH_JOBS_MAX, (int)LV_MAX(rom_num, 1)));
+
+    LV_LOG_USER("batch: %" LV_PRIu32 " ROMs, %" LV_PRIu32 " frames each, %d workers",
+        rom_num, param->frames, jobs);
+
+    uint64_t start = gba_tick_us_get();
+    int alive = 0;
+    for (int i = 0; i < jobs; i++) {
+        if (gba_batch_spawn(shared, paths, param->frames) > 0) {
+            alive++;
+        }
+    }
+
+    while (alive > 0) {
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0) {
+            break;
+        }
+        alive--;
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+            continue;
+        }
+
+        LV_LOG_WARN("batch: worker %d died (status 0x%x)", (int)pid, status);
+        gba_batch_mark_crashed(shared, pid);
+
+        /* Replace it while ROMs are left */
+        if (__atomic_load_n(&shared->next, __ATOMIC_RELAXED) < rom_num
+            && gba_batch_spawn(shared, paths, param->frames) > 0) {
+            alive++;
+        }
+    }
+
+    uint32_t wall_ms = (gba_tick_us_get() - start) / 1000;
+
+    FILE* fp = param->report_path ? fopen(param->report_path, "w") : stdout;
+    if (!fp) {
+        LV_LOG_ERROR("batch: open %s failed", param->report_path);
+        fp = stdout;
+    }
+
+    gba_batch_write_report(fp, shared, paths, wall_ms);
+
+    if (fp != stdout) {
+        fclose(fp);
+    }
+
+    int failed = 0;
+    for (uint32_t i = 0; i < rom_num; i++) {
+        failed += shared->results[i].status != GBA_BATCH_DONE;
+        gba_mem_free(paths[i]);
+    }
+
+    gba_mem_free(paths);
+    munmap(shared, shared_size);
+    return failed;
+}
@@ -0,0 +1,114 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+
+#if HAVE_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * RGB565 mix of the current and the previous frame, weight is the share of
+ * the previous frame in 1/32. The channels are split into 16-bit lanes, the
+ * widest product (63 * 32 + 16) still fits, so 8 pixels go per vector.
+ */
+
+static inline uint16_t gba_blend_pixel(uint16_t cur, uint16_t prev, uint32_t weight)
+{
+    uint32_t inv = GBA_BLEND_WEIGHT_MAX - weight;
+    uint32_t r = ((cur >> 11) * inv + (prev >> 11) * weight + 16) >> 5;
+    uint32_t g = (((cur >> 5) & 0x3F) * inv + ((prev >> 5) & 0x3F) * weight + 16) >> 5;
+    uint32_t b = ((cur & 0x1F) * inv + (prev & 0x1F) * weight + 16) >> 5;
+    return (r << 11) | (g << 5) | b;
+}
+
+void gba_blend_row(uint16_t* dst, uint16_t* prev, const uint16_t* cur, lv_coord_t len, uint32_t weight)
+{
+    LV_ASSERT(weight <= GBA_BLEND_WEIGHT_MAX);
+    uint16_t inv = GBA_BLEND_WEIGHT_MAX - weight;
+    lv_coord_t x = 0;
+
+    /* dst may alias cur: each vector is loaded before it is stored */
+#if HAVE_NEON
+    const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+    const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+    const uint16x8_t round = vdupq_n_u16(16);
+
+    for (; x + 8 <= len; x += 8) {
+        uint16x8_t c = vld1q_u16(cur + x);
+        uint16x8_t p = vld1q_u16(prev + x);
+
+        uint16x8_t r = vmlaq_n_u16(vmlaq_n_u16(round, vshrq_n_u16(c, 11), inv), vshrq_n_u16(p, 11), weight);
+        uint16x8_t g = vmlaq_n_u16(vmlaq_n_u16(round, vandq_u16(vshrq_n_u16(c, 5), mask6), inv),
+            vandq_u16(vshrq_n_u16(p, 5), mask6), weight);
+        uint16x8_t b = vmlaq_n_u16(vmlaq_n_u16(round, vandq_u16(c, mask5), inv), vandq_u16(p, mask5), weight);
+
+        uint16x8_t out = vorrq_u16(vorrq_u16(
+                                       vshlq_n_u16(vshrq_n_u16(r, 5), 11),
+                                       vshlq_n_u16(vshrq_n_u16(g, 5), 5)),
+            vshrq_n_u16(b, 5));
+
+        vst1q_u16(prev + x, c);
+        vst1q_u16(dst + x, out);
+    }
+#elif defined(__SSE2__)
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i round = _mm_set1_epi16(16);
+    const __m128i w_cur = _mm_set1_epi16(inv);
+    const __m128i w_prev = _mm_set1_epi16(weight);
+
+    for (; x + 8 <= len; x += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i*)(cur + x));
+        __m128i p = _mm_loadu_si128((const __m128i*)(prev + x));
+
+        __m128i r = _mm_add_epi16(_mm_add_epi16(
+                                      _mm_mullo_epi16(_mm_srli_epi16(c, 11), w_cur),
+                                      _mm_mullo_epi16(_mm_srli_epi16(p, 11), w_prev)),
+            round);
+        __m128i g = _mm_add_epi16(_mm_add_epi16(
+                                      _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(c, 5), mask6), w_cur),
+                                      _mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(p, 5), mask6), w_prev)),
+            round);
+        __m128i b = _mm_add_epi16(_mm_add_epi16(
+                                      _mm_mullo_epi16(_mm_and_si128(c, mask5), w_cur),
+                                      _mm_mullo_epi16(_mm_and_si128(p, mask5), w_prev)),
+            round);
+
+        __m128i out = _mm_or_si128(_mm_or_si128(
+                                       _mm_slli_epi16(_mm_srli_epi16(r, 5), 11),
+                                       _mm_slli_epi16(_mm_srli_epi16(g, 5), 5)),
+            _mm_srli_epi16(b, 5));
+
+        _mm_storeu_si128((__m128i*)(prev + x), c);
+        _mm_storeu_si128((__m128i*)(dst + x), out);
+    }
+#endif
+
+    for (; x < len; x++) {
+        uint16_t c = cur[x];
+        dst[x] = gba_blend_pixel(c, prev[x], weight);
+        prev[x] = c;
+    }
+}
@@ -0,0 +1,195 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <math.h>
+
+/* Compare the LUT with per-pixel arithmetic when a profile is selected */
+#ifndef GBA_COLOR_BENCH
+#define GBA_COLOR_BENCH 0
+#endif
+
+#define GBA_COLOR_LUT_SIZE 65536
+#define GBA_COLOR_ENCODE_STEPS 4096
+#define GBA_COLOR_OUT_GAMMA 2.2f
+
+/*
+ * Emulates the GBA panel: colors are linearized with the panel gamma, mixed
+ * through the panel primaries (each row sums to 1, white stays white) and
+ * encoded again for a standard display.
+ */
+typedef struct {
+    float gamma;
+    float lum;
+    float mat[3][3];
+} gba_color_profile_t;
+
+static const gba_color_profile_t g_color_profile[_LV_GBA_COLOR_PROFILE_MAX] = {
+    [LV_GBA_COLOR_PROFILE_GBA] = {
+        .gamma = 2.7f,
+        .lum = 0.94f,
+        .mat = {
+            { 0.82f, 0.24f, -0.06f },
+            { 0.125f, 0.665f, 0.21f },
+            { 0.195f, 0.075f, 0.73f },
+        },
+    },
+    [LV_GBA_COLOR_PROFILE_GBA_SP] = {
+        .gamma = 2.2f,
+        .lum = 1.0f,
+        .mat = {
+            { 0.86f, 0.19f, -0.05f },
+            { 0.11f, 0.66f, 0.23f },
+            { 0.1325f, 0.0575f, 0.81f },
+        },
+    },
+};
+
+typedef struct {
+    float lin_r[32];
+    float lin_g[64];
+    float lin_b[32];
+    uint8_t enc5[GBA_COLOR_ENCODE_STEPS];
+    uint8_t enc6[GBA_COLOR_ENCODE_STEPS];
+} gba_color_tables_t;
+
+static void gba_color_tables_init(gba_color_tables_t* tables, const gba_color_profile_t* profile)
+{
+    for (int i = 0; i < 32; i++) {
+        tables->lin_r[i] = powf(i / 31.0f, profile->gamma) * profile->lum;
+        tables->lin_b[i] = tables->lin_r[i];
+    }
+
+    for (int i = 0; i < 64; i++) {
+        tables->lin_g[i] = powf(i / 63.0f, profile->gamma) * profile->lum;
+    }
+
+    for (int i = 0; i < GBA_COLOR_ENCODE_STEPS; i++) {
+        float v = powf(i / (float)(GBA_COLOR_ENCODE_STEPS - 1), 1.0f / GBA_COLOR_OUT_GAMMA);
+        tables->enc5[i] = (uint8_t)(v * 31.0f + 0.5f);
+        tables->enc6[i] = (uint8_t)(v * 63.0f + 0.5f);
+    }
+}
+
+static inline int gba_color_encode_index(float v)
+{
+    v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+    return (int)(v * (GBA_COLOR_ENCODE_STEPS - 1) + 0.5f);
+}
+
+static inline uint16_t gba_color_correct(const gba_color_tables_t* tables, const float (*mat)[3], uint16_t px)
+{
+    float r = tables->lin_r[(px >> 11) & 0x1F];
+    float g = tables->lin_g[(px >> 5) & 0x3F];
+    float b = tables->lin_b[px & 0x1F];
+
+    int r_out = tables->enc5[gba_color_encode_index(mat[0][0] * r + mat[0][1] * g + mat[0][2] * b)];
+    int g_out = tables->enc6[gba_color_encode_index(mat[1][0] * r + mat[1][1] * g + mat[1][2] * b)];
+    int b_out = tables->enc5[gba_color_encode_index(mat[2][0] * r + mat[2][1] * g + mat[2][2] * b)];
+
+    return (r_out << 11) | (g_out << 5) | b_out;
+}
+
+#if GBA_COLOR_BENCH
+static void gba_color_bench(const uint16_t* lut, const gba_color_tables_t* tables, const float (*mat)[3])
+{
+    const int width = 240;
+    const int height = 160;
+    const int rounds = 100;
+
+    uint16_t* src = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, width * height * sizeof(uint16_t) * 2);
+    if (!src) {
+        return;
+    }
+    uint16_t* dst = src + width * height;
+
+    /* Every color of the table, in an order the cache does not like */
+    for (int i = 0; i < width * height; i++) {
+        src[i] = (uint16_t)(i * 40503u);
+    }
+
+    uint64_t start = gba_tick_us_get();
+    for (int n = 0; n < rounds; n++) {
+        gba_color_apply_lut(dst, src, lut, width, height, width);
+    }
+    uint32_t lut_us = (uint32_t)((gba_tick_us_get() - start) / rounds);
+
+    start = gba_tick_us_get();
+    for (int n = 0; n < rounds; n++) {
+        for (int i = 0; i < width * height; i++) {
+            dst[i] = gba_color_correct(tables, mat, src[i]);
+        }
+    }
+    uint32_t math_us = (uint32_t)((gba_tick_us_get() - start) / rounds);
+
+    LV_LOG_USER("color: %dx%d frame, LUT %" LV_PRIu32 " us, arithmetic %" LV_PRIu32 " us",
+        width, height, lut_us, math_us);
+    gba_mem_free(src);
+}
+#endif
+
+uint16_t* gba_color_create_lut(lv_gba_color_profile_t profile)
+{
+    if (profile <= LV_GBA_COLOR_PROFILE_NONE || profile >= _LV_GBA_COLOR_PROFILE_MAX) {
+        return NULL;
+    }
+
+    uint16_t* lut = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, GBA_COLOR_LUT_SIZE * sizeof(uint16_t));
+    gba_color_tables_t* tables = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, sizeof(gba_color_tables_t));
+    if (!lut || !tables) {
+        LV_LOG_ERROR("color: out of memory");
+        gba_mem_free(lut);
+        gba_mem_free(tables);
+        return NULL;
+    }
+
+    uint64_t start = gba_tick_us_get();
+    const gba_color_profile_t* p = &g_color_profile[profile];
+    gba_color_tables_init(tables, p);
+
+    for (uint32_t i = 0; i < GBA_COLOR_LUT_SIZE; i++) {
+        lut[i] = gba_color_correct(tables, p->mat, i);
+    }
+
+    LV_LOG_USER("color: profile %d, LUT built in %" LV_PRIu32 " us",
+        (int)profile, (uint32_t)(gba_tick_us_get() - start));
+
+#if GBA_COLOR_BENCH
+    gba_color_bench(lut, tables, p->mat);
+#endif
+
+    gba_mem_free(tables);
+    return lut;
+}
+
+void gba_color_apply_lut(uint16_t* dst, const uint16_t* src, const uint16_t* lut,
+    lv_coord_t width, lv_coord_t height, lv_coord_t stride)
+{
+    for (lv_coord_t y = 0; y < height; y++) {
+        const uint16_t* s = src + y * stride;
+        uint16_t* d = dst + y * stride;
+
+        for (lv_coord_t x = 0; x < width; x++) {
+            d[x] = lut[s[x]];
+        }
+    }
+}
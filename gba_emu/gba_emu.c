@@ -23,6 +23,7 @@
 #include "gba_emu.h"
 #include "gba_internal.h"
 #include "lvgl/lvgl.h"
+#include <string.h>
 
 static void gba_context_init(gba_context_t* ctx)
 {
@@ -37,30 +38,25 @@ static void gba_emu_timer_cb(lv_timer_t* timer)
     gba_retro_run(gba_ctx);
 }
 
-static bool gba_emu_change_rom_size(const char* path)
+static void gba_emu_unload_game(gba_context_t* ctx)
 {
-    lv_fs_file_t file;
-    lv_fs_res_t res = lv_fs_open(&file, path, LV_FS_MODE_RD);
-    if (res != LV_FS_RES_OK) {
-        LV_LOG_ERROR("open %s failed: %d", path, res);
-        return false;
+    /* Nothing was loaded */
+    if (ctx->rom_path[0] == '\0') {
+        return;
     }
 
-    lv_fs_seek(&file, 0, LV_FS_SEEK_END);
-
-    uint32_t pos;
-    res = lv_fs_tell(&file, &pos);
-    lv_fs_close(&file);
+    if (ctx->auto_resume) {
+        gba_state_suspend(ctx);
+    }
 
-    if (res != LV_FS_RES_OK) {
-        LV_LOG_ERROR("get file size failed: %d", res);
-        return false;
+    /* The core still holds the last frame, already taken when paused */
+    if (!ctx->paused) {
+        gba_thumb_capture(ctx);
     }
 
-    void gba_set_rom_size(int size);
-    gba_set_rom_size(pos);
-    LV_LOG_USER("ROM: %s size = %" LV_PRIu32 " Bytes", path, pos);
-    return true;
+    gba_state_deinit(ctx);
+    gba_autosave_deinit(ctx);
+    gba_retro_save_game(ctx);
 }
 
 static void on_delete_event_cb(lv_event_t* e)
@@ -72,12 +68,16 @@ static void on_delete_event_cb(lv_event_t* e)
         lv_timer_del(gba_ctx->timer);
     }
 
-    gba_retro_save_game(gba_ctx);
+    gba_view_hide_output(gba_ctx);
+    gba_record_stop(gba_ctx);
+    gba_rewind_deinit(gba_ctx);
+    gba_emu_unload_game(gba_ctx);
 
     gba_view_deinit(gba_ctx);
     gba_retro_deinit(gba_ctx);
+    gba_rom_close();
     _lv_ll_clear(&gba_ctx->input_event_ll);
-    lv_free(gba_ctx);
+    gba_mem_free(gba_ctx);
 }
 
 lv_obj_t* lv_gba_emu_create(lv_obj_t* par, const char* rom_file_path, lv_gba_view_mode_t mode)
@@ -85,37 +85,159 @@ lv_obj_t* lv_gba_emu_create(lv_obj_t* par, const char* rom_file_path, lv_gba_vie
     LV_ASSERT_NULL(rom_file_path);
     lv_obj_t* root;
 
-    gba_context_t* gba_ctx = lv_malloc(sizeof(gba_context_t));
+    gba_context_t* gba_ctx = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, sizeof(gba_context_t));
     LV_ASSERT_MALLOC(gba_ctx);
     gba_context_init(gba_ctx);
+    gba_ctx->create_tick = gba_tick_us_get();
 
     char real_path[512];
     lv_snprintf(real_path, sizeof(real_path), "/%s", rom_file_path);
 
-    if (!gba_emu_change_rom_size(real_path)) {
+    /*
+     * The core and the ROM mapping are per process. Refuse before opening,
+     * gba_rom_open() would close the ROM of the running instance.
+     */
+    if (gba_retro_is_busy()) {
+        LV_LOG_ERROR("the core is already used by another instance");
+        gba_mem_free(gba_ctx);
         return NULL;
     }
 
-    gba_retro_init(gba_ctx);
+    /* retro_init() sizes the ROM buffer, the ROM must be open first */
+    if (!gba_rom_open(real_path)) {
+        gba_mem_free(gba_ctx);
+        return NULL;
+    }
+
+    if (!gba_retro_init(gba_ctx)) {
+        gba_rom_close();
+        gba_mem_free(gba_ctx);
+        return NULL;
+    }
 
     gba_view_init(gba_ctx, par, mode);
 
+    uint64_t load_start = gba_tick_us_get();
+
     if (!gba_retro_load_game(gba_ctx, real_path)) {
         LV_LOG_ERROR("load ROM: %s failed", real_path);
         goto failed;
     }
 
+    LV_LOG_USER("ROM loaded in %" LV_PRIu32 " us", (uint32_t)(gba_tick_us_get() - load_start));
+
     lv_strncpy(gba_ctx->rom_path, real_path, sizeof(gba_ctx->rom_path) - 1);
     gba_retro_load_save(gba_ctx);
+    gba_autosave_init(gba_ctx);
 
     gba_ctx->timer = lv_timer_create(gba_emu_timer_cb, 1000 / gba_ctx->av_info.fps, gba_ctx);
 
+    /* Compare with "ROM switched in" of a warm switch */
+    LV_LOG_USER("Emulator created in %" LV_PRIu32 " us", (uint32_t)(gba_tick_us_get() - gba_ctx->create_tick));
+
 failed:
     root = gba_view_get_root(gba_ctx);
     lv_obj_add_event(root, on_delete_event_cb, LV_EVENT_DELETE, gba_ctx);
     return root;
 }
 
+bool lv_gba_emu_switch_rom(lv_obj_t* gba_emu, const char* rom_file_path)
+{
+    LV_ASSERT_NULL(rom_file_path);
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+
+    char real_path[512];
+    lv_snprintf(real_path, sizeof(real_path), "/%s", rom_file_path);
+
+    /* Same game: it is still loaded, just carry on */
+    if (gba_ctx->frame_cnt > 0 && strcmp(gba_ctx->rom_path, real_path) == 0) {
+        lv_gba_emu_set_paused(gba_emu, false);
+        return true;
+    }
+
+    uint64_t start = gba_tick_us_get();
+
+    if (gba_ctx->timer) {
+        lv_timer_pause(gba_ctx->timer);
+    }
+
+    /* Only the content changes: the view, the audio output and the rewind buffers stay */
+    gba_rewind_reset(gba_ctx);
+    gba_emu_unload_game(gba_ctx);
+    gba_retro_unload_game(gba_ctx);
+    gba_rom_close();
+
+    /*
+     * The core sizes and claims the ROM buffer when it starts: the new ROM
+     * must be open first. On failure the core still restarts, so that the
+     * instance can be deleted normally.
+     */
+    bool opened = gba_rom_open(real_path);
+    gba_retro_restart(gba_ctx);
+
+    gba_ctx->frame_cnt = 0;
+    gba_ctx->create_tick = start;
+    gba_ctx->key_state = 0;
+    gba_ctx->key_state_prev = 0;
+    gba_ctx->select_press_tick = 0;
+    gba_ctx->hotkey_used = false;
+    gba_ctx->state_req = GBA_STATE_REQ_NONE;
+    gba_ctx->rewind_active = false;
+    gba_ctx->rom_path[0] = '\0';
+
+    if (!opened || !gba_retro_load_game(gba_ctx, real_path)) {
+        LV_LOG_ERROR("switch ROM: %s failed", real_path);
+        return false;
+    }
+
+    lv_strncpy(gba_ctx->rom_path, real_path, sizeof(gba_ctx->rom_path) - 1);
+    gba_retro_load_save(gba_ctx);
+    gba_autosave_init(gba_ctx);
+
+    if (gba_ctx->auto_resume) {
+        gba_state_resume(gba_ctx);
+    }
+
+    /* Same steps as "Emulator created in" of a cold start */
+    LV_LOG_USER("ROM switched in %" LV_PRIu32 " us", (uint32_t)(gba_tick_us_get() - start));
+
+    gba_ctx->paused = false;
+    if (gba_ctx->timer) {
+        lv_timer_resume(gba_ctx->timer);
+    } else {
+        gba_ctx->timer = lv_timer_create(gba_emu_timer_cb, 1000 / gba_ctx->av_info.fps, gba_ctx);
+    }
+
+    return true;
+}
+
+void lv_gba_emu_set_paused(lv_obj_t* gba_emu, bool en)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+
+    if (gba_ctx->paused == en) {
+        return;
+    }
+
+    if (en) {
+        if (gba_ctx->timer) {
+            lv_timer_pause(gba_ctx->timer);
+        }
+
+        /* The menu shows the current frame and the progress is on disk while waiting */
+        gba_view_hide_output(gba_ctx);
+        gba_thumb_capture(gba_ctx);
+        gba_autosave_wait(gba_ctx);
+        gba_retro_save_game(gba_ctx);
+    } else if (gba_ctx->timer) {
+        lv_timer_resume(gba_ctx->timer);
+    }
+
+    gba_ctx->paused = en;
+}
+
 void lv_gba_emu_add_input_read_cb(lv_obj_t* gba_emu, lv_gba_emu_input_read_cb_t read_cb, void* user_data)
 {
     gba_context_t* ctx = lv_obj_get_user_data(gba_emu);
@@ -141,6 +263,19 @@ void lv_gba_emu_set_audio_output_cb(lv_obj_t* gba_emu, lv_gba_emu_audio_output_c
     gba_ctx->audio_output_user_data = user_data;
 }
 
+void lv_gba_emu_set_video_output_cb(lv_obj_t* gba_emu, lv_gba_emu_video_output_cb_t video_output_cb, void* user_data)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+
+    /* The previous output stops showing the screen, LVGL draws it again */
+    gba_view_hide_output(gba_ctx);
+    gba_ctx->video_output_cb = video_output_cb;
+    gba_ctx->video_output_user_data = user_data;
+    gba_view_set_output_key(gba_ctx, video_output_cb != NULL);
+    gba_view_invalidate_frame(gba_ctx);
+}
+
 void lv_gba_emu_set_on_exit_cb(lv_obj_t* gba_emu, void (*exit_cb)(void*), void* user_data)
 {
     gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
@@ -148,3 +283,88 @@ void lv_gba_emu_set_on_exit_cb(lv_obj_t* gba_emu, void (*exit_cb)(void*), void*
     gba_ctx->exit_cb = exit_cb;
     gba_ctx->exit_cb_user_data = user_data;
 }
+
+bool lv_gba_emu_save_state(lv_obj_t* gba_emu, int slot)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    return gba_state_save(gba_ctx, slot);
+}
+
+bool lv_gba_emu_load_state(lv_obj_t* gba_emu, int slot)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    return gba_state_load(gba_ctx, slot);
+}
+
+bool lv_gba_emu_set_rewind(lv_obj_t* gba_emu, size_t budget, uint32_t interval)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    return gba_rewind_init(gba_ctx, budget, interval);
+}
+
+void lv_gba_emu_set_auto_resume(lv_obj_t* gba_emu, bool en)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    gba_ctx->auto_resume = en;
+
+    /* Only resume a game that has not started running yet */
+    if (en && gba_ctx->frame_cnt == 0) {
+        gba_state_resume(gba_ctx);
+    }
+}
+
+void lv_gba_emu_set_color_profile(lv_obj_t* gba_emu, lv_gba_color_profile_t profile)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    gba_view_set_color_profile(gba_ctx, profile);
+}
+
+void lv_gba_emu_set_frame_blend(lv_obj_t* gba_emu, int percent)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+
+    /* Share of the previous frame: 0 disables, 50 is an even mix */
+    percent = LV_CLAMP(0, percent, 100);
+    gba_view_set_frame_blend(gba_ctx, (percent * GBA_BLEND_WEIGHT_MAX + 50) / 100);
+}
+
+bool lv_gba_emu_start_record(lv_obj_t* gba_emu, const char* video_path, const char* audio_path)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    return gba_record_start(gba_ctx, video_path, audio_path);
+}
+
+void lv_gba_emu_stop_record(lv_obj_t* gba_emu)
+{
+    gba_context_t* gba_ctx = lv_obj_get_user_data(gba_emu);
+    LV_ASSERT_NULL(gba_ctx);
+    gba_record_stop(gba_ctx);
+}
+
+void lv_gba_emu_set_rom_demand_paging(bool en)
+{
+    /* Takes effect for the next ROM opened by lv_gba_emu_create() */
+    gba_rom_set_demand_paging(en);
+}
+
+void lv_gba_emu_track_mem(lv_gba_mem_tag_t tag, ptrdiff_t size)
+{
+    gba_mem_track(tag, size);
+}
+
+bool lv_gba_emu_get_mem_stat(lv_gba_mem_tag_t tag, lv_gba_mem_stat_t* stat)
+{
+    return gba_mem_get_stat(tag, stat);
+}
+
+void lv_gba_emu_dump_mem(void)
+{
+    gba_mem_dump();
+}
@@ -34,14 +34,75 @@ typedef enum {
     LV_GBA_VIEW_MODE_VIRTUAL_KEYPAD,
 } lv_gba_view_mode_t;
 
+/* Emulated LCD for the color correction */
+typedef enum {
+    LV_GBA_COLOR_PROFILE_NONE,
+    LV_GBA_COLOR_PROFILE_GBA, /* Original GBA, dark reflective panel */
+    LV_GBA_COLOR_PROFILE_GBA_SP, /* Backlit GBA SP (AGS-101) */
+    _LV_GBA_COLOR_PROFILE_MAX
+} lv_gba_color_profile_t;
+
+/* Owners of the memory accounted by lv_gba_emu_get_mem_stat() */
+typedef enum {
+    LV_GBA_MEM_TAG_CORE, /* Emulator core regions (memalign path and arena) */
+    LV_GBA_MEM_TAG_EMU, /* Emulator context and view */
+    LV_GBA_MEM_TAG_STATE, /* Save states, autosave snapshot and rewind history */
+    LV_GBA_MEM_TAG_IO, /* ROM loading: VFS buffers, archives, inflate */
+    LV_GBA_MEM_TAG_MENU, /* Search index and thumbnails */
+    LV_GBA_MEM_TAG_PORT, /* Display buffers and audio FIFO */
+    LV_GBA_MEM_TAG_RECORD, /* Video recording frame pool */
+    _LV_GBA_MEM_TAG_MAX
+} lv_gba_mem_tag_t;
+
+typedef struct {
+    size_t cur;
+    size_t peak;
+    uint32_t alloc_cnt;
+} lv_gba_mem_stat_t;
+
+typedef struct {
+    const char* dir_path; /* ROMs of this library, subfolders included */
+    const char* file_path; /* Only this ROM when set */
+    uint32_t frames; /* Run by every ROM */
+    int jobs; /* Worker processes, 0: one per CPU */
+    const char* report_path; /* NULL: stdout */
+} lv_gba_emu_batch_param_t;
+
 typedef uint32_t (*lv_gba_emu_input_read_cb_t)(void* user_data);
 typedef size_t (*lv_gba_emu_audio_output_cb_t)(void* user_data, const int16_t* data, size_t frames);
 
+/*
+ * With a video output the screen area is filled with this color instead of
+ * the frame. The port draws the frame below the UI and shows it through the
+ * pixels of this color, so widgets over the screen stay on top.
+ */
+#define LV_GBA_EMU_VIDEO_KEY_COLOR lv_color_hex(0xFF00FF)
+
+/* buf and area are NULL when the screen is hidden, stride is in pixels, area in display coordinates */
+typedef void (*lv_gba_emu_video_output_cb_t)(void* user_data, const uint16_t* buf,
+    int32_t width, int32_t height, int32_t stride, const lv_area_t* area);
+
 lv_obj_t* lv_gba_emu_create(lv_obj_t* par, const char* rom_file_path, lv_gba_view_mode_t mode);
+bool lv_gba_emu_switch_rom(lv_obj_t* gba_emu, const char* rom_file_path);
+void lv_gba_emu_set_paused(lv_obj_t* gba_emu, bool en);
 void lv_gba_emu_add_input_read_cb(lv_obj_t* gba_emu, lv_gba_emu_input_read_cb_t read_cb, void* user_data);
 int lv_gba_emu_get_audio_sample_rate(lv_obj_t* gba_emu);
 void lv_gba_emu_set_audio_output_cb(lv_obj_t* gba_emu, lv_gba_emu_audio_output_cb_t audio_output_cb, void* user_data);
+void lv_gba_emu_set_video_output_cb(lv_obj_t* gba_emu, lv_gba_emu_video_output_cb_t video_output_cb, void* user_data);
 void lv_gba_emu_set_on_exit_cb(lv_obj_t* gba_emu, void (*exit_cb)(void*), void* user_data);
+bool lv_gba_emu_save_state(lv_obj_t* gba_emu, int slot);
+bool lv_gba_emu_load_state(lv_obj_t* gba_emu, int slot);
+bool lv_gba_emu_set_rewind(lv_obj_t* gba_emu, size_t budget, uint32_t interval);
+void lv_gba_emu_set_auto_resume(lv_obj_t* gba_emu, bool en);
+void lv_gba_emu_set_color_profile(lv_obj_t* gba_emu, lv_gba_color_profile_t profile);
+void lv_gba_emu_set_frame_blend(lv_obj_t* gba_emu, int percent);
+bool lv_gba_emu_start_record(lv_obj_t* gba_emu, const char* video_path, const char* audio_path);
+void lv_gba_emu_stop_record(lv_obj_t* gba_emu);
+void lv_gba_emu_set_rom_demand_paging(bool en);
+void lv_gba_emu_track_mem(lv_gba_mem_tag_t tag, ptrdiff_t size);
+bool lv_gba_emu_get_mem_stat(lv_gba_mem_tag_t tag, lv_gba_mem_stat_t* stat);
+void lv_gba_emu_dump_mem(void);
+int lv_gba_emu_run_batch(const lv_gba_emu_batch_param_t* param);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,527 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <string.h>
+
+/*
+ * Streaming raw DEFLATE (RFC 1951) decoder.
+ * Input is pulled through a callback, output goes straight into the caller's
+ * buffer. Only the 32 KB history window is kept as extra copy of the data.
+ */
+
+#define GBA_INFLATE_FAST_BITS 9
+#define GBA_INFLATE_FAST_MASK ((1 << GBA_INFLATE_FAST_BITS) - 1)
+#define GBA_INFLATE_WINDOW_SIZE 32768
+#define GBA_INFLATE_WINDOW_MASK (GBA_INFLATE_WINDOW_SIZE - 1)
+#define GBA_INFLATE_IN_BUF_SIZE 16384
+#define GBA_INFLATE_NUM_SYMS 288
+
+/* The bit buffer may hold up to 4 bytes of padding zeros past the end of input */
+#define GBA_INFLATE_OVERRUN_MAX 4
+
+typedef struct {
+    uint16_t fast[1 << GBA_INFLATE_FAST_BITS];
+    uint16_t firstcode[16];
+    int32_t maxcode[17];
+    uint16_t firstsymbol[16];
+    uint8_t size[GBA_INFLATE_NUM_SYMS];
+    uint16_t value[GBA_INFLATE_NUM_SYMS];
+} gba_huffman_t;
+
+typedef enum {
+    GBA_INFLATE_STATE_HEADER,
+    GBA_INFLATE_STATE_STORED,
+    GBA_INFLATE_STATE_HUFFMAN,
+    GBA_INFLATE_STATE_DONE,
+    GBA_INFLATE_STATE_ERROR,
+} gba_inflate_state_t;
+
+struct gba_inflate_s {
+    gba_inflate_read_cb_t read_cb;
+    void* user_data;
+
+    uint8_t in_buf[GBA_INFLATE_IN_BUF_SIZE];
+    size_t in_pos;
+    size_t in_len;
+    uint32_t overrun;
+
+    uint32_t code_buffer;
+    int num_bits;
+
+    uint8_t window[GBA_INFLATE_WINDOW_SIZE];
+    uint64_t total_out;
+
+    gba_inflate_state_t state;
+    bool final;
+    uint32_t stored_remain;
+    uint32_t match_len;
+    uint32_t match_dist;
+
+    gba_huffman_t lit;
+    gba_huffman_t dist;
+};
+
+static const uint16_t length_base[31] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258, 0, 0
+};
+
+static const uint8_t length_extra[31] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0, 0, 0
+};
+
+static const uint16_t dist_base[32] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577, 0, 0
+};
+
+static const uint8_t dist_extra[32] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13, 0, 0
+};
+
+static inline int gba_inflate_bit_reverse(int v, int bits)
+{
+    int r = 0;
+    for (int i = 0; i < bits; i++) {
+        r = (r << 1) | (v & 1);
+        v >>= 1;
+    }
+    return r;
+}
+
+static bool gba_huffman_build(gba_huffman_t* h, const uint8_t* sizelist, int num)
+{
+    int sizes[17];
+    int next_code[16];
+
+    memset(sizes, 0, sizeof(sizes));
+    memset(h->fast, 0, sizeof(h->fast));
+
+    for (int i = 0; i < num; i++) {
+        sizes[sizelist[i]]++;
+    }
+    sizes[0] = 0;
+
+    for (int i = 1; i < 16; i++) {
+        if (sizes[i] > (1 << i)) {
+            return false;
+        }
+    }
+
+    int code = 0;
+    int k = 0;
+    for (int i = 1; i < 16; i++) {
+        next_code[i] = code;
+        h->firstcode[i] = code;
+        h->firstsymbol[i] = k;
+        code += sizes[i];
+        if (sizes[i] && code - 1 >= (1 << i)) {
+            return false;
+        }
+        /* Pre-shifted for the slow path */
+        h->maxcode[i] = code << (16 - i);
+        code <<= 1;
+        k += sizes[i];
+    }
+    h->maxcode[16] = 0x10000;
+
+    for (int i = 0; i < num; i++) {
+        int s = sizelist[i];
+        if (s == 0) {
+            continue;
+        }
+
+        int c = next_code[s] - h->firstcode[s] + h->firstsymbol[s];
+        h->size[c] = s;
+        h->value[c] = i;
+
+        if (s <= GBA_INFLATE_FAST_BITS) {
+            uint16_t fastv = (s << 9) | i;
+            for (int j = gba_inflate_bit_reverse(next_code[s], s); j < (1 << GBA_INFLATE_FAST_BITS); j += 1 << s) {
+                h->fast[j] = fastv;
+            }
+        }
+        next_code[s]++;
+    }
+
+    return true;
+}
+
+static inline uint8_t gba_inflate_get_byte(gba_inflate_t* inf)
+{
+    if (inf->in_pos == inf->in_len) {
+        inf->in_pos = 0;
+        inf->in_len = inf->read_cb(inf->user_data, inf->in_buf, sizeof(inf->in_buf));
+        if (inf->in_len == 0) {
+            /* Feed zeros past the end, the decoder fails if it really needs them */
+            inf->overrun++;
+            return 0;
+        }
+    }
+    return inf->in_buf[inf->in_pos++];
+}
+
+static inline void gba_inflate_fill_bits(gba_inflate_t* inf)
+{
+    while (inf->num_bits <= 24) {
+        inf->code_buffer |= (uint32_t)gba_inflate_get_byte(inf) << inf->num_bits;
+        inf->num_bits += 8;
+    }
+}
+
+static inline uint32_t gba_inflate_get_bits(gba_inflate_t* inf, int n)
+{
+    if (inf->num_bits < n) {
+        gba_inflate_fill_bits(inf);
+    }
+    uint32_t v = inf->code_buffer & ((1U << n) - 1);
+    inf->code_buffer >>= n;
+    inf->num_bits -= n;
+    return v;
+}
+
+static int gba_huffman_decode_slow(gba_inflate_t* inf, const gba_huffman_t* h)
+{
+    int k = gba_inflate_bit_reverse(inf->code_buffer, 16);
+    int s;
+    for (s = GBA_INFLATE_FAST_BITS + 1; s < 16; s++) {
+        if (k < h->maxcode[s]) {
+            break;
+        }
+    }
+
+    if (s >= 16) {
+        return -1;
+    }
+
+    int b = (k >> (16 - s)) - h->firstcode[s] + h->firstsymbol[s];
+    if (b >= GBA_INFLATE_NUM_SYMS || h->size[b] != s) {
+        return -1;
+    }
+
+    inf->code_buffer >>= s;
+    inf->num_bits -= s;
+    return h->value[b];
+}
+
+static inline int gba_huffman_decode(gba_inflate_t* inf, const gba_huffman_t* h)
+{
+    if (inf->num_bits < 16) {
+        gba_inflate_fill_bits(inf);
+    }
+
+    uint16_t b = h->fast[inf->code_buffer & GBA_INFLATE_FAST_MASK];
+    if (b) {
+        int s = b >> 9;
+        inf->code_buffer >>= s;
+        inf->num_bits -= s;
+        return b & 511;
+    }
+
+    return gba_huffman_decode_slow(inf, h);
+}
+
+static bool gba_inflate_build_fixed(gba_inflate_t* inf)
+{
+    uint8_t sizes[GBA_INFLATE_NUM_SYMS];
+    int i = 0;
+
+    for (; i <= 143; i++) {
+        sizes[i] = 8;
+    }
+    for (; i <= 255; i++) {
+        sizes[i] = 9;
+    }
+    for (; i <= 279; i++) {
+        sizes[i] = 7;
+    }
+    for (; i <= 287; i++) {
+        sizes[i] = 8;
+    }
+
+    if (!gba_huffman_build(&inf->lit, sizes, GBA_INFLATE_NUM_SYMS)) {
+        return false;
+    }
+
+    memset(sizes, 5, 32);
+    return gba_huffman_build(&inf->dist, sizes, 32);
+}
+
+static bool gba_inflate_build_dynamic(gba_inflate_t* inf)
+{
+    static const uint8_t order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+    };
+
+    uint8_t lencodes[286 + 32 + 137];
+    uint8_t codelength_sizes[19];
+    gba_huffman_t* codelength = &inf->dist;
+
+    int hlit = gba_inflate_get_bits(inf, 5) + 257;
+    int hdist = gba_inflate_get_bits(inf, 5) + 1;
+    int hclen = gba_inflate_get_bits(inf, 4) + 4;
+    int ntot = hlit + hdist;
+
+    memset(codelength_sizes, 0, sizeof(codelength_sizes));
+    for (int i = 0; i < hclen; i++) {
+        codelength_sizes[order[i]] = gba_inflate_get_bits(inf, 3);
+    }
+
+    /* The distance table is free until the real one is built */
+    if (!gba_huffman_build(codelength, codelength_sizes, 19)) {
+        return false;
+    }
+
+    int n = 0;
+    while (n < ntot) {
+        int c = gba_huffman_decode(inf, codelength);
+        if (c < 0 || c >= 19) {
+            return false;
+        }
+
+        if (c < 16) {
+            lencodes[n++] = c;
+            continue;
+        }
+
+        uint8_t fill = 0;
+        if (c == 16) {
+            c = gba_inflate_get_bits(inf, 2) + 3;
+            if (n == 0) {
+                return false;
+            }
+            fill = lencodes[n - 1];
+        } else if (c == 17) {
+            c = gba_inflate_get_bits(inf, 3) + 3;
+        } else {
+            c = gba_inflate_get_bits(inf, 7) + 11;
+        }
+
+        if (ntot - n < c) {
+            return false;
+        }
+
+        memset(lencodes + n, fill, c);
+        n += c;
+    }
+
+    if (!gba_huffman_build(&inf->lit, lencodes, hlit)) {
+        return false;
+    }
+
+    return gba_huffman_build(&inf->dist, lencodes + hlit, hdist);
+}
+
+static bool gba_inflate_block_header(gba_inflate_t* inf)
+{
+    inf->final = gba_inflate_get_bits(inf, 1);
+    int type = gba_inflate_get_bits(inf, 2);
+
+    switch (type) {
+    case 0: {
+        /* Stored block: drop to the byte boundary, then LEN and NLEN */
+        gba_inflate_get_bits(inf, inf->num_bits & 7);
+        uint32_t len = gba_inflate_get_bits(inf, 16);
+        uint32_t nlen = gba_inflate_get_bits(inf, 16);
+        if ((len ^ 0xFFFF) != nlen) {
+            return false;
+        }
+        inf->stored_remain = len;
+        inf->state = GBA_INFLATE_STATE_STORED;
+        return true;
+    }
+    case 1:
+        inf->state = GBA_INFLATE_STATE_HUFFMAN;
+        return gba_inflate_build_fixed(inf);
+    case 2:
+        inf->state = GBA_INFLATE_STATE_HUFFMAN;
+        return gba_inflate_build_dynamic(inf);
+    default:
+        return false;
+    }
+}
+
+static inline void gba_inflate_put(gba_inflate_t* inf, uint8_t* out, uint8_t c)
+{
+    *out = c;
+    inf->window[inf->total_out & GBA_INFLATE_WINDOW_MASK] = c;
+    inf->total_out++;
+}
+
+static size_t gba_inflate_stored(gba_inflate_t* inf, uint8_t* out, size_t len)
+{
+    size_t n = inf->stored_remain < len ? inf->stored_remain : len;
+
+    /* Bytes already in the bit buffer come first */
+    size_t i = 0;
+    for (; i < n && inf->num_bits >= 8; i++) {
+        gba_inflate_put(inf, out + i, gba_inflate_get_bits(inf, 8));
+    }
+
+    for (; i < n; i++) {
+        gba_inflate_put(inf, out + i, gba_inflate_get_byte(inf));
+    }
+
+    inf->stored_remain -= n;
+    return n;
+}
+
+static size_t gba_inflate_huffman(gba_inflate_t* inf, uint8_t* out, size_t len)
+{
+    size_t produced = 0;
+
+    while (produced < len) {
+        if (inf->match_len > 0) {
+            uint32_t n = inf->match_len;
+            if (n > len - produced) {
+                n = len - produced;
+            }
+
+            for (uint32_t i = 0; i < n; i++) {
+                uint8_t c = inf->window[(inf->total_out - inf->match_dist) & GBA_INFLATE_WINDOW_MASK];
+                gba_inflate_put(inf, out + produced++, c);
+            }
+
+            inf->match_len -= n;
+            continue;
+        }
+
+        int sym = gba_huffman_decode(inf, &inf->lit);
+
+        if (sym < 0 || inf->overrun > GBA_INFLATE_OVERRUN_MAX) {
+            inf->state = GBA_INFLATE_STATE_ERROR;
+            break;
+        }
+
+        if (sym < 256) {
+            gba_inflate_put(inf, out + produced++, sym);
+            continue;
+        }
+
+        if (sym == 256) {
+            inf->state = inf->final ? GBA_INFLATE_STATE_DONE : GBA_INFLATE_STATE_HEADER;
+            break;
+        }
+
+        sym -= 257;
+        if (sym >= 29) {
+            inf->state = GBA_INFLATE_STATE_ERROR;
+            break;
+        }
+
+        uint32_t match_len = length_base[sym] + gba_inflate_get_bits(inf, length_extra[sym]);
+
+        int dsym = gba_huffman_decode(inf, &inf->dist);
+        if (dsym < 0 || dsym >= 30) {
+            inf->state = GBA_INFLATE_STATE_ERROR;
+            break;
+        }
+
+        uint32_t dist = dist_base[dsym] + gba_inflate_get_bits(inf, dist_extra[dsym]);
+        if (dist > inf->total_out) {
+            inf->state = GBA_INFLATE_STATE_ERROR;
+            break;
+        }
+
+        inf->match_len = match_len;
+        inf->match_dist = dist;
+    }
+
+    return produced;
+}
+
+gba_inflate_t* gba_inflate_create(gba_inflate_read_cb_t read_cb, void* user_data)
+{
+    gba_inflate_t* inf = gba_mem_alloc(LV_GBA_MEM_TAG_IO, sizeof(gba_inflate_t));
+    LV_ASSERT_MALLOC(inf);
+    if (!inf) {
+        return NULL;
+    }
+
+    inf->read_cb = read_cb;
+    inf->user_data = user_data;
+    gba_inflate_reset(inf);
+    return inf;
+}
+
+void gba_inflate_delete(gba_inflate_t* inf)
+{
+    gba_mem_free(inf);
+}
+
+void gba_inflate_reset(gba_inflate_t* inf)
+{
+    inf->in_pos = 0;
+    inf->in_len = 0;
+    inf->overrun = 0;
+    inf->code_buffer = 0;
+    inf->num_bits = 0;
+    inf->total_out = 0;
+    inf->state = GBA_INFLATE_STATE_HEADER;
+    inf->final = false;
+    inf->stored_remain = 0;
+    inf->match_len = 0;
+    inf->match_dist = 0;
+}
+
+int64_t gba_inflate_read(gba_inflate_t* inf, void* buf, size_t len)
+{
+    uint8_t* out = buf;
+    size_t produced = 0;
+
+    while (produced < len) {
+        switch (inf->state) {
+        case GBA_INFLATE_STATE_HEADER:
+            if (!gba_inflate_block_header(inf)) {
+                inf->state = GBA_INFLATE_STATE_ERROR;
+            }
+            break;
+
+        case GBA_INFLATE_STATE_STORED:
+            produced += gba_inflate_stored(inf, out + produced, len - produced);
+            if (inf->stored_remain == 0) {
+                inf->state = inf->final ? GBA_INFLATE_STATE_DONE : GBA_INFLATE_STATE_HEADER;
+            }
+            break;
+
+        case GBA_INFLATE_STATE_HUFFMAN:
+            produced += gba_inflate_huffman(inf, out + produced, len - produced);
+            break;
+
+        case GBA_INFLATE_STATE_DONE:
+            return produced;
+
+        case GBA_INFLATE_STATE_ERROR:
+        default:
+            return -1;
+        }
+
+        if (inf->overrun > GBA_INFLATE_OVERRUN_MAX) {
+            inf->state = GBA_INFLATE_STATE_ERROR;
+        }
+    }
+
+    return produced;
+}
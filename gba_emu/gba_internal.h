@@ -23,6 +23,7 @@
 #ifndef GBA_INTERNAL_H
 #define GBA_INTERNAL_H
 
+#include "gba_emu.h"
 #include "lvgl/lvgl.h"
 
 #ifdef __cplusplus
@@ -31,6 +32,21 @@ extern "C" {
 
 #define GBA_ARRAY_SIZE(arr) (sizeof(arr) / sizeof(arr[0]))
 
+#define GBA_STATE_SLOT_NUM 10
+#define GBA_STATE_SLOT_RESUME GBA_STATE_SLOT_NUM
+
+/* Bytes hashed to identify a ROM: covers the header and the start of the code */
+#define GBA_ROM_HASH_SIZE (64 * 1024)
+
+#define GBA_SEARCH_QUERY_MAX 32
+
+/* Frame blending weights are in 1/32 */
+#define GBA_BLEND_WEIGHT_MAX 32
+
+/* Half of the GBA screen */
+#define GBA_THUMB_WIDTH 120
+#define GBA_THUMB_HEIGHT 80
+
 typedef enum {
     GBA_JOYPAD_B,
     GBA_JOYPAD_Y,
@@ -52,6 +68,50 @@ typedef enum {
 } gba_joypad_id_t;
 
 typedef struct gba_view_s gba_view_t;
+typedef struct gba_autosave_s gba_autosave_t;
+typedef struct gba_state_s gba_state_t;
+typedef struct gba_rewind_s gba_rewind_t;
+typedef struct gba_record_s gba_record_t;
+typedef struct gba_inflate_s gba_inflate_t;
+typedef struct gba_archive_s gba_archive_t;
+
+typedef struct gba_library_s gba_library_t;
+typedef struct gba_search_s gba_search_t;
+
+typedef struct {
+    char path[192];
+    int64_t mtime;
+} gba_library_dir_t;
+
+typedef struct {
+    char path[192]; /* Relative to the library root */
+    char title[13];
+    char code[5];
+    uint16_t dir;
+    uint32_t size;
+    uint32_t crc32; /* Of the first 64 KB, identifies the ROM content */
+    uint32_t scan_id; /* Of the last scan that listed it */
+    int64_t mtime;
+} gba_library_entry_t;
+
+typedef void (*gba_library_update_cb_t)(gba_library_t* library, bool done, void* user_data);
+
+typedef size_t (*gba_inflate_read_cb_t)(void* user_data, uint8_t* buf, size_t len);
+
+typedef enum {
+    GBA_STATE_REQ_NONE,
+    GBA_STATE_REQ_SAVE,
+    GBA_STATE_REQ_LOAD,
+} gba_state_req_t;
+
+typedef void (*gba_worker_cb_t)(void* user_data);
+
+typedef struct gba_worker_job_s {
+    struct gba_worker_job_s* next;
+    gba_worker_cb_t cb;
+    void* user_data;
+    bool busy;
+} gba_worker_job_t;
 
 typedef struct {
     uint32_t (*read_cb)(void* user_data);
@@ -60,8 +120,14 @@ typedef struct {
 
 typedef struct gba_context_s {
     gba_view_t* view;
+    gba_autosave_t* autosave;
+    gba_state_t* state;
+    gba_rewind_t* rewind;
+    gba_record_t* record;
     lv_timer_t* timer;
     bool invalidate;
+    bool paused;
+    const uint16_t* frame; /* Last frame of the core */
 
     struct {
         lv_coord_t fb_width;
@@ -72,28 +138,156 @@ typedef struct gba_context_s {
     } av_info;
 
     uint32_t key_state;
+    uint32_t key_state_prev;
     lv_ll_t input_event_ll;
     size_t (*audio_output_cb)(void* user_data, const int16_t* data, size_t frames);
     void* audio_output_user_data;
+    lv_gba_emu_video_output_cb_t video_output_cb;
+    void* video_output_user_data;
 
     void (*exit_cb)(void* user_data);
     void* exit_cb_user_data;
     uint32_t select_press_tick;
+    bool hotkey_used;
+
+    uint32_t frame_cnt;
+    uint64_t create_tick;
+    bool auto_resume;
+
+    int state_slot;
+    gba_state_req_t state_req;
+    bool rewind_active;
     char rom_path[256];
 } gba_context_t;
 
-void gba_retro_init(gba_context_t* ctx);
+bool gba_retro_is_busy(void);
+bool gba_retro_init(gba_context_t* ctx);
 void gba_retro_deinit(gba_context_t* ctx);
 bool gba_retro_load_game(gba_context_t* ctx, const char* path);
+void gba_retro_unload_game(gba_context_t* ctx);
+void gba_retro_restart(gba_context_t* ctx);
 void gba_retro_save_game(gba_context_t* ctx);
 void gba_retro_load_save(gba_context_t* ctx);
 void gba_retro_run(gba_context_t* ctx);
+void gba_retro_get_file_path(char* path, size_t len, const char* rom_path, const char* ext);
+void gba_retro_get_save_path(char* save_path, size_t len, const char* rom_path);
+
+void gba_autosave_init(gba_context_t* ctx);
+void gba_autosave_deinit(gba_context_t* ctx);
+void gba_autosave_wait(gba_context_t* ctx);
+void gba_autosave_update(gba_context_t* ctx);
+
+void gba_state_deinit(gba_context_t* ctx);
+void gba_state_update(gba_context_t* ctx);
+bool gba_state_save(gba_context_t* ctx, int slot);
+bool gba_state_load(gba_context_t* ctx, int slot);
+void gba_state_suspend(gba_context_t* ctx);
+bool gba_state_resume(gba_context_t* ctx);
+
+bool gba_rewind_init(gba_context_t* ctx, size_t budget, uint32_t interval);
+void gba_rewind_deinit(gba_context_t* ctx);
+void gba_rewind_reset(gba_context_t* ctx);
+void gba_rewind_update(gba_context_t* ctx);
+
+bool gba_record_start(gba_context_t* ctx, const char* video_path, const char* audio_path);
+void gba_record_stop(gba_context_t* ctx);
+void gba_record_audio(gba_context_t* ctx, const int16_t* data, size_t frames);
+void gba_record_frame(gba_context_t* ctx);
 
 void gba_view_init(gba_context_t* ctx, lv_obj_t* par, int mode);
 void gba_view_deinit(gba_context_t* ctx);
 lv_obj_t* gba_view_get_root(gba_context_t* ctx);
 void gba_view_draw_frame(gba_context_t* ctx, const uint16_t* buf, lv_coord_t width, lv_coord_t height);
 void gba_view_invalidate_frame(gba_context_t* ctx);
+void gba_view_hide_output(gba_context_t* ctx);
+void gba_view_set_output_key(gba_context_t* ctx, bool en);
+const uint16_t* gba_view_get_frame(gba_context_t* ctx);
+void gba_view_set_color_profile(gba_context_t* ctx, lv_gba_color_profile_t profile);
+void gba_view_set_frame_blend(gba_context_t* ctx, uint32_t weight);
+
+uint16_t* gba_color_create_lut(lv_gba_color_profile_t profile);
+void gba_color_apply_lut(uint16_t* dst, const uint16_t* src, const uint16_t* lut,
+    lv_coord_t width, lv_coord_t height, lv_coord_t stride);
+
+void gba_blend_row(uint16_t* dst, uint16_t* prev, const uint16_t* cur, lv_coord_t len, uint32_t weight);
+
+void gba_worker_job_init(gba_worker_job_t* job, gba_worker_cb_t cb, void* user_data);
+bool gba_worker_submit(gba_worker_job_t* job);
+bool gba_worker_is_busy(gba_worker_job_t* job);
+void gba_worker_wait(gba_worker_job_t* job);
+
+gba_library_t* gba_library_open(const char* dir_path);
+void gba_library_close(gba_library_t* library);
+bool gba_library_refresh(gba_library_t* library, gba_library_update_cb_t cb, void* user_data);
+void gba_library_cancel(gba_library_t* library);
+bool gba_library_is_scanning(gba_library_t* library);
+uint32_t gba_library_get_count(gba_library_t* library);
+const gba_library_entry_t* gba_library_get_entry(gba_library_t* library, uint32_t index);
+int32_t gba_library_find_index(gba_library_t* library, const char* rel_path);
+
+void gba_prefetch_start(const char* path);
+void gba_prefetch_cancel(void);
+
+gba_search_t* gba_search_create(void);
+void gba_search_delete(gba_search_t* search);
+bool gba_search_build(gba_search_t* search, gba_library_t* library);
+uint32_t gba_search_query(gba_search_t* search, const char* query, const uint32_t** results);
+
+void gba_thumb_set_dir(const char* dir_path);
+void gba_thumb_capture(gba_context_t* ctx);
+const uint16_t* gba_thumb_get(uint32_t crc32, uint32_t size);
+
+bool gba_arena_init(void);
+void* gba_arena_alloc(size_t size, size_t boundary);
+bool gba_arena_free(void* ptr);
+void gba_arena_report(void);
+void gba_arena_reset(void);
+
+bool gba_rom_open(const char* path);
+void gba_rom_close(void);
+void gba_rom_set_demand_paging(bool en);
+void gba_rom_update(void);
+void gba_rom_report(void);
+bool gba_rom_want_hugepage(const char* path, size_t size);
+void* gba_rom_mmap(int fd, size_t size, int prot);
+bool gba_rom_is_file(const char* path);
+void* gba_rom_claim_buffer(size_t size);
+bool gba_rom_release_buffer(void* ptr);
+int64_t gba_rom_read_mapped(const void* dst, uint64_t pos, uint64_t len);
+
+gba_inflate_t* gba_inflate_create(gba_inflate_read_cb_t read_cb, void* user_data);
+void gba_inflate_delete(gba_inflate_t* inf);
+void gba_inflate_reset(gba_inflate_t* inf);
+int64_t gba_inflate_read(gba_inflate_t* inf, void* buf, size_t len);
+
+bool gba_archive_is_supported(const char* path);
+bool gba_archive_get_size(const char* path, size_t* size);
+gba_archive_t* gba_archive_open(const char* path);
+void gba_archive_close(gba_archive_t* archive);
+int64_t gba_archive_read(gba_archive_t* archive, void* buf, uint64_t len);
+int64_t gba_archive_seek(gba_archive_t* archive, int64_t offset, int seek_position);
+int64_t gba_archive_tell(gba_archive_t* archive);
+int64_t gba_archive_size(gba_archive_t* archive);
+
+size_t gba_lz_compress_bound(size_t size);
+size_t gba_lz_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity);
+size_t gba_lz_decompress(const void* src, size_t src_size, void* dst, size_t dst_size);
+
+void* gba_mem_alloc(lv_gba_mem_tag_t tag, size_t size);
+void* gba_mem_alloc_zeroed(lv_gba_mem_tag_t tag, size_t size);
+void* gba_mem_realloc(lv_gba_mem_tag_t tag, void* ptr, size_t size);
+char* gba_mem_strdup(lv_gba_mem_tag_t tag, const char* str);
+void gba_mem_free(void* ptr);
+void gba_mem_track(lv_gba_mem_tag_t tag, ptrdiff_t size);
+bool gba_mem_get_stat(lv_gba_mem_tag_t tag, lv_gba_mem_stat_t* stat);
+void gba_mem_dump(void);
+
+uint64_t gba_tick_us_get(void);
+uint32_t gba_uptime_ms_get(void);
+uint32_t gba_crc32(uint32_t crc, const void* buf, size_t len);
+size_t gba_smaps_get_kb(const void* addr, size_t len, const char* field);
+void gba_fs_get_native_path(char* buf, size_t len, const char* path);
+bool gba_fs_write_file_atomic(const char* native_path, const void* data, size_t size);
 
 #ifdef __cplusplus
 }
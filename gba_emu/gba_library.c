@@ -0,0 +1,898 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * ROM library index, persisted next to the ROMs.
+ * A directory is only listed again when its mtime changed, otherwise the
+ * entries stored for it are trusted as they are.
+ *
+ * The tree is walked by a job on the shared worker, which stops after a
+ * batch of ROMs or a time slice. A timer on the LVGL thread merges each
+ * batch and resubmits the job, so the menu fills up while the scan runs and
+ * other worker jobs (prefetch) get their turn in between.
+ * The job uses libc and POSIX only. It only reads the stored entries, which
+ * are modified by the LVGL thread while the job is idle.
+ */
+
+#define GBA_LIBRARY_INDEX_NAME ".gba_library.idx"
+#define GBA_LIBRARY_MAGIC 0x4C414247 /* "GBAL" */
+#define GBA_LIBRARY_VERSION 3
+
+#define GBA_HEADER_TITLE_OFFSET 0xA0
+#define GBA_HEADER_SIZE 0xC0
+
+#ifndef GBA_LIBRARY_DEPTH_MAX
+#define GBA_LIBRARY_DEPTH_MAX 8
+#endif
+
+/* A job returns after this many listed ROMs or this much time */
+#define GBA_LIBRARY_BATCH_SIZE 64
+#define GBA_LIBRARY_BATCH_TIME_US (20 * 1000)
+#define GBA_LIBRARY_POLL_PERIOD 10
+
+/* Stored for a directory that was not listed completely yet */
+#define GBA_LIBRARY_MTIME_UNKNOWN (-2)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t dir_num;
+    uint32_t entry_num;
+    uint32_t scan_id;
+    uint32_t crc32; /* Of the dirs and the entries that follow */
+} gba_library_file_header_t;
+
+typedef enum {
+    GBA_LIBRARY_BATCH_UNCHANGED,
+    GBA_LIBRARY_BATCH_LISTED,
+    GBA_LIBRARY_BATCH_FOUND,
+} gba_library_batch_type_t;
+
+typedef struct {
+    gba_library_dir_t dir;
+    gba_library_batch_type_t type;
+
+    /* A large directory is listed over several batches */
+    bool last;
+
+    /* Listed entries, in the batch entries */
+    uint32_t entry_start;
+    uint32_t entry_num;
+} gba_library_batch_dir_t;
+
+struct gba_library_s {
+    char root[256];
+    char index_path[300];
+
+    gba_library_dir_t* dirs;
+    uint32_t dir_num;
+    uint32_t dir_cap;
+
+    gba_library_entry_t* entries;
+    uint32_t entry_num;
+    uint32_t entry_cap;
+
+    bool dirty;
+
+    /* Stamped on the entries listed by a scan, the others of a listed directory are stale */
+    uint32_t scan_id;
+
+    struct {
+        gba_worker_job_t job;
+        lv_timer_t* timer;
+        gba_library_update_cb_t cb;
+        void* user_data;
+        volatile bool cancel;
+
+        /* Owned by the job while it runs, by the LVGL thread otherwise */
+        DIR* dir;
+        gba_library_dir_t dir_info;
+
+        gba_library_dir_t* pending;
+        uint32_t pending_num;
+        uint32_t pending_cap;
+
+        gba_library_batch_dir_t* batch_dirs;
+        uint32_t batch_dir_num;
+        uint32_t batch_dir_cap;
+
+        gba_library_entry_t* batch_entries;
+        uint32_t batch_entry_num;
+        uint32_t batch_entry_cap;
+
+        /* Directories visited by this scan, the others are dropped at the end */
+        uint8_t* seen;
+        uint32_t seen_cap;
+
+        uint32_t listed_num;
+        uint32_t hashed_num;
+        uint32_t reused_num;
+        uint64_t start_tick;
+    } scan;
+};
+
+static bool gba_library_is_rom(const char* name)
+{
+    const char* ext = strrchr(name, '.');
+    if (!ext) {
+        return false;
+    }
+    ext++;
+    return strcasecmp(ext, "gba") == 0 || strcasecmp(ext, "zip") == 0 || strcasecmp(ext, "gz") == 0;
+}
+
+static int64_t gba_library_get_mtime(const struct stat* st)
+{
+    /* Nanoseconds, so two changes within the same second are still told apart */
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+}
+
+static void gba_library_join(char* buf, size_t len, const char* base, const char* name)
+{
+    if (base[0] == '\0') {
+        snprintf(buf, len, "%s", name);
+    } else if (name[0] == '\0') {
+        snprintf(buf, len, "%s", base);
+    } else {
+        snprintf(buf, len, "%s/%s", base, name);
+    }
+}
+
+static uint32_t gba_library_get_depth(const char* rel_path)
+{
+    if (rel_path[0] == '\0') {
+        return 0;
+    }
+
+    uint32_t depth = 1;
+    while ((rel_path = strchr(rel_path, '/')) != NULL) {
+        depth++;
+        rel_path++;
+    }
+    return depth;
+}
+
+static bool gba_library_is_child(const char* parent, const char* path)
+{
+    size_t len = strlen(parent);
+    if (len > 0) {
+        if (strncmp(path, parent, len) != 0 || path[len] != '/') {
+            return false;
+        }
+        len++;
+    }
+    return path[len] != '\0' && strchr(path + len, '/') == NULL;
+}
+
+static int gba_library_entry_cmp(const void* a, const void* b)
+{
+    const gba_library_entry_t* ea = a;
+    const gba_library_entry_t* eb = b;
+    return strcasecmp(ea->path, eb->path);
+}
+
+static bool gba_library_reserve(void** array, uint32_t* cap, uint32_t num, size_t item_size)
+{
+    if (num < *cap) {
+        return true;
+    }
+
+    uint32_t new_cap = *cap ? *cap * 2 : 64;
+    void* new_array = realloc(*array, new_cap * item_size);
+    if (!new_array) {
+        return false;
+    }
+
+    *array = new_array;
+    *cap = new_cap;
+    return true;
+}
+
+static int32_t gba_library_find_dir(gba_library_t* library, const char* rel_path)
+{
+    for (uint32_t i = 0; i < library->dir_num; i++) {
+        if (strcmp(library->dirs[i].path, rel_path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int32_t gba_library_add_dir(gba_library_t* library, const char* rel_path, int64_t mtime)
+{
+    /* Entries refer to their directory with 16 bits */
+    if (library->dir_num > UINT16_MAX
+        || !gba_library_reserve((void**)&library->dirs, &library->dir_cap, library->dir_num, sizeof(gba_library_dir_t))) {
+        return -1;
+    }
+
+    gba_library_dir_t* dir = &library->dirs[library->dir_num];
+    memset(dir, 0, sizeof(gba_library_dir_t));
+    snprintf(dir->path, sizeof(dir->path), "%s", rel_path);
+    dir->mtime = mtime;
+    return library->dir_num++;
+}
+
+static void gba_library_read_info(const char* path, gba_library_entry_t* entry)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    uint8_t* buf = malloc(GBA_ROM_HASH_SIZE);
+    if (!buf) {
+        close(fd);
+        return;
+    }
+
+    ssize_t len = read(fd, buf, GBA_ROM_HASH_SIZE);
+    close(fd);
+
+    if (len > 0) {
+        entry->crc32 = gba_crc32(0, buf, len);
+    }
+
+    /* Compressed ROMs keep an empty title, the file name is shown instead */
+    if (len >= GBA_HEADER_SIZE && strcasecmp(strrchr(path, '.'), ".gba") == 0) {
+        memcpy(entry->title, buf + GBA_HEADER_TITLE_OFFSET, sizeof(entry->title) - 1);
+        memcpy(entry->code, buf + GBA_HEADER_TITLE_OFFSET + 12, sizeof(entry->code) - 1);
+    }
+
+    free(buf);
+}
+
+static gba_library_entry_t* gba_library_find(gba_library_t* library, const char* rel_path)
+{
+    if (library->entry_num == 0) {
+        return NULL;
+    }
+
+    gba_library_entry_t key;
+    snprintf(key.path, sizeof(key.path), "%s", rel_path);
+    return bsearch(&key, library->entries, library->entry_num, sizeof(gba_library_entry_t), gba_library_entry_cmp);
+}
+
+static void gba_library_push_dir(gba_library_t* library, const char* rel_path)
+{
+    if (!gba_library_reserve((void**)&library->scan.pending, &library->scan.pending_cap,
+            library->scan.pending_num, sizeof(gba_library_dir_t))) {
+        return;
+    }
+
+    gba_library_dir_t* dir = &library->scan.pending[library->scan.pending_num++];
+    snprintf(dir->path, sizeof(dir->path), "%s", rel_path);
+}
+
+static gba_library_batch_dir_t* gba_library_add_batch_dir(gba_library_t* library, const char* rel_path,
+    int64_t mtime, gba_library_batch_type_t type)
+{
+    if (!gba_library_reserve((void**)&library->scan.batch_dirs, &library->scan.batch_dir_cap,
+            library->scan.batch_dir_num, sizeof(gba_library_batch_dir_t))) {
+        return NULL;
+    }
+
+    gba_library_batch_dir_t* batch_dir = &library->scan.batch_dirs[library->scan.batch_dir_num++];
+    memset(batch_dir, 0, sizeof(gba_library_batch_dir_t));
+    snprintf(batch_dir->dir.path, sizeof(batch_dir->dir.path), "%s", rel_path);
+    batch_dir->dir.mtime = mtime;
+    batch_dir->type = type;
+    batch_dir->entry_start = library->scan.batch_entry_num;
+    return batch_dir;
+}
+
+static bool gba_library_batch_is_full(gba_library_t* library, uint64_t start)
+{
+    return library->scan.batch_entry_num >= GBA_LIBRARY_BATCH_SIZE
+        || gba_tick_us_get() - start >= GBA_LIBRARY_BATCH_TIME_US;
+}
+
+static void gba_library_list_dir(gba_library_t* library, uint64_t start)
+{
+    const char* dir_rel = library->scan.dir_info.path;
+    bool descend = gba_library_get_depth(dir_rel) < GBA_LIBRARY_DEPTH_MAX;
+
+    uint32_t batch_index = library->scan.batch_dir_num;
+    gba_library_batch_dir_t* batch_dir = gba_library_add_batch_dir(library, dir_rel,
+        library->scan.dir_info.mtime, GBA_LIBRARY_BATCH_LISTED);
+    if (!batch_dir) {
+        closedir(library->scan.dir);
+        library->scan.dir = NULL;
+        return;
+    }
+
+    bool end = false;
+    bool failed = false;
+    while (!library->scan.cancel && !gba_library_batch_is_full(library, start)) {
+        struct dirent* ent = readdir(library->scan.dir);
+        if (!ent) {
+            end = true;
+            break;
+        }
+
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+
+        char rel_path[sizeof(library->dirs[0].path)];
+        gba_library_join(rel_path, sizeof(rel_path), dir_rel, ent->d_name);
+
+        char file_path[512];
+        gba_library_join(file_path, sizeof(file_path), library->root, rel_path);
+
+        struct stat st;
+        if (ent->d_type == DT_DIR || ent->d_type == DT_UNKNOWN) {
+            /* Symlinked directories are not followed, they could form a loop */
+            if (lstat(file_path, &st) == 0 && S_ISDIR(st.st_mode)) {
+                if (descend) {
+                    gba_library_add_batch_dir(library, rel_path, GBA_LIBRARY_MTIME_UNKNOWN, GBA_LIBRARY_BATCH_FOUND);
+                    gba_library_push_dir(library, rel_path);
+                }
+                continue;
+            }
+        }
+
+        if (!gba_library_is_rom(ent->d_name) || stat(file_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+
+        if (!gba_library_reserve((void**)&library->scan.batch_entries, &library->scan.batch_entry_cap,
+                library->scan.batch_entry_num, sizeof(gba_library_entry_t))) {
+            failed = true;
+            break;
+        }
+
+        gba_library_entry_t* entry = &library->scan.batch_entries[library->scan.batch_entry_num++];
+        const gba_library_entry_t* old = gba_library_find(library, rel_path);
+        library->scan.listed_num++;
+
+        if (old && old->size == (uint32_t)st.st_size && old->mtime == gba_library_get_mtime(&st)) {
+            *entry = *old;
+            library->scan.reused_num++;
+            continue;
+        }
+
+        memset(entry, 0, sizeof(gba_library_entry_t));
+        snprintf(entry->path, sizeof(entry->path), "%s", rel_path);
+        entry->size = st.st_size;
+        entry->mtime = gba_library_get_mtime(&st);
+        gba_library_read_info(file_path, entry);
+        library->scan.hashed_num++;
+    }
+
+    /* Taken again, the list grows with the subdirectories found */
+    batch_dir = &library->scan.batch_dirs[batch_index];
+    batch_dir->entry_num = library->scan.batch_entry_num - batch_dir->entry_start;
+    batch_dir->last = end;
+
+    if (end || failed) {
+        closedir(library->scan.dir);
+        library->scan.dir = NULL;
+    }
+}
+
+static void gba_library_visit_dir(gba_library_t* library, const char* dir_rel)
+{
+    char dir_path[512];
+    gba_library_join(dir_path, sizeof(dir_path), library->root, dir_rel);
+
+    struct stat st;
+    int64_t mtime = stat(dir_path, &st) == 0 && S_ISDIR(st.st_mode) ? gba_library_get_mtime(&st) : -1;
+
+    int32_t known = gba_library_find_dir(library, dir_rel);
+    if (mtime >= 0 && known >= 0 && library->dirs[known].mtime == mtime) {
+        gba_library_add_batch_dir(library, dir_rel, mtime, GBA_LIBRARY_BATCH_UNCHANGED);
+
+        /* The subdirectories are known from the index as well */
+        for (uint32_t i = 0; i < library->dir_num; i++) {
+            if (gba_library_is_child(dir_rel, library->dirs[i].path)) {
+                gba_library_push_dir(library, library->dirs[i].path);
+            }
+        }
+        return;
+    }
+
+    DIR* d = mtime >= 0 ? opendir(dir_path) : NULL;
+    if (!d) {
+        /* Gone or unreadable: no entries */
+        gba_library_batch_dir_t* batch_dir = gba_library_add_batch_dir(library, dir_rel, mtime, GBA_LIBRARY_BATCH_LISTED);
+        if (batch_dir) {
+            batch_dir->last = true;
+        }
+        return;
+    }
+
+    library->scan.dir = d;
+    library->scan.dir_info.mtime = mtime;
+    snprintf(library->scan.dir_info.path, sizeof(library->scan.dir_info.path), "%s", dir_rel);
+}
+
+static void gba_library_scan_job_cb(void* user_data)
+{
+    gba_library_t* library = user_data;
+    uint64_t start = gba_tick_us_get();
+
+    while (!library->scan.cancel && !gba_library_batch_is_full(library, start)) {
+        if (library->scan.dir) {
+            gba_library_list_dir(library, start);
+        } else if (library->scan.pending_num > 0) {
+            gba_library_dir_t dir = library->scan.pending[--library->scan.pending_num];
+            gba_library_visit_dir(library, dir.path);
+        } else {
+            break;
+        }
+    }
+}
+
+static void gba_library_mark_seen(gba_library_t* library, uint32_t dir_index)
+{
+    if (dir_index >= library->scan.seen_cap) {
+        uint32_t new_cap = library->dir_cap;
+        uint8_t* seen = realloc(library->scan.seen, new_cap);
+        if (!seen) {
+            return;
+        }
+        memset(seen + library->scan.seen_cap, 0, new_cap - library->scan.seen_cap);
+        library->scan.seen = seen;
+        library->scan.seen_cap = new_cap;
+    }
+
+    library->scan.seen[dir_index] = 1;
+}
+
+static void gba_library_merge_entries(gba_library_t* library, uint32_t dir_index,
+    const gba_library_entry_t* entries, uint32_t entry_num, uint32_t sorted_num)
+{
+    for (uint32_t i = 0; i < entry_num; i++) {
+        /* Entries appended by this merge are not sorted yet, and never listed twice */
+        gba_library_entry_t* entry = sorted_num ? bsearch(&entries[i], library->entries, sorted_num,
+                                         sizeof(gba_library_entry_t), gba_library_entry_cmp)
+                                                : NULL;
+
+        if (!entry) {
+            if (!gba_library_reserve((void**)&library->entries, &library->entry_cap,
+                    library->entry_num, sizeof(gba_library_entry_t))) {
+                break;
+            }
+            entry = &library->entries[library->entry_num++];
+        }
+
+        *entry = entries[i];
+        entry->dir = dir_index;
+        entry->scan_id = library->scan_id;
+    }
+}
+
+static void gba_library_remove_stale(gba_library_t* library, const uint8_t* listed)
+{
+    uint32_t keep = 0;
+    for (uint32_t i = 0; i < library->entry_num; i++) {
+        const gba_library_entry_t* entry = &library->entries[i];
+        if (!listed[entry->dir] || entry->scan_id == library->scan_id) {
+            library->entries[keep++] = *entry;
+        }
+    }
+    library->entry_num = keep;
+}
+
+static bool gba_library_merge_batch(gba_library_t* library)
+{
+    bool changed = false;
+    uint32_t sorted_num = library->entry_num;
+
+    /* Directories listed completely by this batch, indexed like the entries refer to them */
+    uint8_t* listed = NULL;
+
+    for (uint32_t i = 0; i < library->scan.batch_dir_num; i++) {
+        const gba_library_batch_dir_t* batch_dir = &library->scan.batch_dirs[i];
+        int32_t dir_index = gba_library_find_dir(library, batch_dir->dir.path);
+
+        if (batch_dir->type == GBA_LIBRARY_BATCH_FOUND) {
+            /* Recorded right away, so that an interrupted scan still lists it next time */
+            if (dir_index < 0) {
+                gba_library_add_dir(library, batch_dir->dir.path, GBA_LIBRARY_MTIME_UNKNOWN);
+                library->dirty = true;
+            }
+            continue;
+        }
+
+        /* Gone: dropped at the end of the scan if it was stored */
+        if (batch_dir->dir.mtime < 0 && dir_index < 0) {
+            continue;
+        }
+
+        if (dir_index < 0) {
+            dir_index = gba_library_add_dir(library, batch_dir->dir.path, batch_dir->dir.mtime);
+            if (dir_index < 0) {
+                continue;
+            }
+        }
+
+        if (batch_dir->dir.mtime >= 0) {
+            gba_library_mark_seen(library, dir_index);
+        }
+
+        if (batch_dir->type == GBA_LIBRARY_BATCH_LISTED) {
+            /* Trusted only once listed completely */
+            library->dirs[dir_index].mtime = GBA_LIBRARY_MTIME_UNKNOWN;
+            gba_library_merge_entries(library, dir_index,
+                &library->scan.batch_entries[batch_dir->entry_start], batch_dir->entry_num, sorted_num);
+
+            if (batch_dir->last && !listed) {
+                listed = calloc(UINT16_MAX + 1, 1);
+            }
+            if (batch_dir->last && listed) {
+                listed[dir_index] = 1;
+                library->dirs[dir_index].mtime = batch_dir->dir.mtime;
+            }
+            library->dirty = true;
+            changed = true;
+        }
+    }
+
+    library->scan.batch_dir_num = 0;
+    library->scan.batch_entry_num = 0;
+
+    if (listed) {
+        gba_library_remove_stale(library, listed);
+        free(listed);
+    }
+
+    if (changed) {
+        qsort(library->entries, library->entry_num, sizeof(gba_library_entry_t), gba_library_entry_cmp);
+    }
+    return changed;
+}
+
+static bool gba_library_remove_unseen(gba_library_t* library)
+{
+    uint16_t* remap = malloc(LV_MAX(library->dir_num, 1) * sizeof(uint16_t));
+    if (!remap) {
+        return false;
+    }
+
+    uint32_t keep = 0;
+    for (uint32_t i = 0; i < library->dir_num; i++) {
+        if (i < library->scan.seen_cap && library->scan.seen[i]) {
+            remap[i] = keep;
+            library->dirs[keep++] = library->dirs[i];
+        } else {
+            remap[i] = UINT16_MAX;
+        }
+    }
+
+    bool changed = keep != library->dir_num;
+    library->dir_num = keep;
+
+    if (changed) {
+        keep = 0;
+        for (uint32_t i = 0; i < library->entry_num; i++) {
+            uint16_t dir = remap[library->entries[i].dir];
+            if (dir != UINT16_MAX) {
+                library->entries[keep] = library->entries[i];
+                library->entries[keep++].dir = dir;
+            }
+        }
+        library->entry_num = keep;
+        library->dirty = true;
+    }
+
+    free(remap);
+    return changed;
+}
+
+static uint32_t gba_library_payload_crc32(const gba_library_t* library)
+{
+    uint32_t crc = gba_crc32(0, library->dirs, library->dir_num * sizeof(gba_library_dir_t));
+    return gba_crc32(crc, library->entries, library->entry_num * sizeof(gba_library_entry_t));
+}
+
+static bool gba_library_load(gba_library_t* library)
+{
+    FILE* fp = fopen(library->index_path, "rb");
+    if (!fp) {
+        return false;
+    }
+
+    gba_library_file_header_t header;
+    bool ok = fread(&header, sizeof(header), 1, fp) == 1
+        && header.magic == GBA_LIBRARY_MAGIC
+        && header.version == GBA_LIBRARY_VERSION;
+
+    if (ok) {
+        library->dirs = malloc(LV_MAX(header.dir_num, 1) * sizeof(gba_library_dir_t));
+        library->entries = malloc(LV_MAX(header.entry_num, 1) * sizeof(gba_library_entry_t));
+        ok = library->dirs && library->entries
+            && fread(library->dirs, sizeof(gba_library_dir_t), header.dir_num, fp) == header.dir_num
+            && fread(library->entries, sizeof(gba_library_entry_t), header.entry_num, fp) == header.entry_num;
+    }
+    fclose(fp);
+
+    if (ok) {
+        library->dir_num = header.dir_num;
+        library->entry_num = header.entry_num;
+        ok = gba_library_payload_crc32(library) == header.crc32;
+    }
+
+    if (!ok) {
+        library->dir_num = library->entry_num = 0;
+        free(library->dirs);
+        free(library->entries);
+        library->dirs = NULL;
+        library->entries = NULL;
+        LV_LOG_WARN("library: ignoring invalid index %s", library->index_path);
+        return false;
+    }
+
+    library->dir_cap = header.dir_num;
+    library->entry_cap = header.entry_num;
+    library->scan_id = header.scan_id;
+    return true;
+}
+
+static void gba_library_save(gba_library_t* library)
+{
+    /*
+     * Rewritten in place: creating the file is the only change to the
+     * directory mtime, and it is picked up right here instead of causing
+     * a rescan on the next start. A torn write fails the CRC check on
+     * load and only costs a rescan.
+     */
+    FILE* fp = fopen(library->index_path, "r+b");
+    if (!fp) {
+        fp = fopen(library->index_path, "wb");
+        if (!fp) {
+            /* A read-only ROM directory just means rescanning next time */
+            return;
+        }
+
+        struct stat st;
+        for (uint32_t i = 0; i < library->dir_num; i++) {
+            if (library->dirs[i].path[0] == '\0' && stat(library->root, &st) == 0) {
+                library->dirs[i].mtime = gba_library_get_mtime(&st);
+            }
+        }
+    }
+
+    gba_library_file_header_t header = {
+        .magic = GBA_LIBRARY_MAGIC,
+        .version = GBA_LIBRARY_VERSION,
+        .dir_num = library->dir_num,
+        .entry_num = library->entry_num,
+        .scan_id = library->scan_id,
+        .crc32 = gba_library_payload_crc32(library),
+    };
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+        && fwrite(library->dirs, sizeof(gba_library_dir_t), library->dir_num, fp) == library->dir_num
+        && fwrite(library->entries, sizeof(gba_library_entry_t), library->entry_num, fp) == library->entry_num;
+
+    /* Drop the tail of a previously longer index */
+    ok = fflush(fp) == 0 && ok;
+    ok = ok && ftruncate(fileno(fp), ftell(fp)) == 0;
+    fclose(fp);
+
+    if (ok) {
+        library->dirty = false;
+    } else {
+        LV_LOG_WARN("library: failed to write %s", library->index_path);
+    }
+}
+
+static void gba_library_scan_stop(gba_library_t* library)
+{
+    if (library->scan.dir) {
+        closedir(library->scan.dir);
+        library->scan.dir = NULL;
+    }
+
+    lv_timer_delete(library->scan.timer);
+    library->scan.timer = NULL;
+    library->scan.cb = NULL;
+    library->scan.user_data = NULL;
+    library->scan.pending_num = 0;
+
+    if (library->dirty) {
+        gba_library_save(library);
+    }
+}
+
+static void gba_library_scan_submit(gba_library_t* library)
+{
+    /* Without a worker thread the scan still makes progress, one batch per poll */
+    if (!gba_worker_submit(&library->scan.job)) {
+        gba_library_scan_job_cb(library);
+    }
+}
+
+static void gba_library_timer_cb(lv_timer_t* timer)
+{
+    gba_library_t* library = lv_timer_get_user_data(timer);
+
+    if (gba_worker_is_busy(&library->scan.job)) {
+        return;
+    }
+
+    bool changed = gba_library_merge_batch(library);
+    bool done = library->scan.pending_num == 0 && !library->scan.dir;
+
+    if (!done) {
+        gba_library_scan_submit(library);
+    } else {
+        changed = gba_library_remove_unseen(library) || changed;
+
+        LV_LOG_USER("library: %" LV_PRIu32 " ROMs in %" LV_PRIu32 " dirs ready in %" LV_PRIu32 " ms, "
+                    "%" LV_PRIu32 " listed, %" LV_PRIu32 " hashed, %" LV_PRIu32 " unchanged",
+            library->entry_num, library->dir_num,
+            (uint32_t)((gba_tick_us_get() - library->scan.start_tick) / 1000),
+            library->scan.listed_num, library->scan.hashed_num, library->scan.reused_num);
+    }
+
+    gba_library_update_cb_t cb = library->scan.cb;
+    void* user_data = library->scan.user_data;
+
+    if (done) {
+        gba_library_scan_stop(library);
+    }
+
+    if (cb && (changed || done)) {
+        cb(library, done, user_data);
+    }
+}
+
+gba_library_t* gba_library_open(const char* dir_path)
+{
+    LV_ASSERT_NULL(dir_path);
+
+    gba_library_t* library = calloc(1, sizeof(gba_library_t));
+    if (!library) {
+        return NULL;
+    }
+
+    gba_fs_get_native_path(library->root, sizeof(library->root), dir_path);
+    size_t root_len = strlen(library->root);
+    if (root_len > 1 && library->root[root_len - 1] == '/') {
+        library->root[root_len - 1] = '\0';
+    }
+    if (library->root[0] == '\0') {
+        strcpy(library->root, ".");
+    }
+    snprintf(library->index_path, sizeof(library->index_path), "%s/%s", library->root, GBA_LIBRARY_INDEX_NAME);
+
+    uint64_t start = gba_tick_us_get();
+    if (gba_library_load(library)) {
+        LV_LOG_USER("library: loaded %" LV_PRIu32 " entries in %" LV_PRIu32 " us",
+            library->entry_num, (uint32_t)(gba_tick_us_get() - start));
+    }
+
+    return library;
+}
+
+void gba_library_close(gba_library_t* library)
+{
+    if (!library) {
+        return;
+    }
+
+    gba_library_cancel(library);
+
+    free(library->scan.pending);
+    free(library->scan.batch_dirs);
+    free(library->scan.batch_entries);
+    free(library->scan.seen);
+    free(library->dirs);
+    free(library->entries);
+    free(library);
+}
+
+bool gba_library_refresh(gba_library_t* library, gba_library_update_cb_t cb, void* user_data)
+{
+    LV_ASSERT_NULL(library);
+
+    struct stat root_st;
+    if (stat(library->root, &root_st) != 0 || !S_ISDIR(root_st.st_mode)) {
+        LV_LOG_WARN("library: %s is not a directory", library->root);
+        return false;
+    }
+
+    library->scan.cb = cb;
+    library->scan.user_data = user_data;
+
+    /* Already running: only the listener changes */
+    if (library->scan.timer) {
+        return true;
+    }
+
+    if (library->scan.job.cb == NULL) {
+        gba_worker_job_init(&library->scan.job, gba_library_scan_job_cb, library);
+    }
+
+    if (library->scan.seen) {
+        memset(library->scan.seen, 0, library->scan.seen_cap);
+    }
+    library->scan_id++;
+    library->scan.cancel = false;
+    library->scan.pending_num = 0;
+    library->scan.batch_dir_num = 0;
+    library->scan.batch_entry_num = 0;
+    library->scan.listed_num = 0;
+    library->scan.hashed_num = 0;
+    library->scan.reused_num = 0;
+    library->scan.start_tick = gba_tick_us_get();
+
+    gba_library_push_dir(library, "");
+    library->scan.timer = lv_timer_create(gba_library_timer_cb, GBA_LIBRARY_POLL_PERIOD, library);
+    gba_library_scan_submit(library);
+    return true;
+}
+
+void gba_library_cancel(gba_library_t* library)
+{
+    LV_ASSERT_NULL(library);
+
+    if (!library->scan.timer) {
+        return;
+    }
+
+    library->scan.cancel = true;
+    gba_worker_wait(&library->scan.job);
+
+    /* Dropped, a directory is listed again unless all of it was merged */
+    library->scan.batch_dir_num = 0;
+    library->scan.batch_entry_num = 0;
+
+    LV_LOG_USER("library: scan cancelled after %" LV_PRIu32 " ms",
+        (uint32_t)((gba_tick_us_get() - library->scan.start_tick) / 1000));
+
+    gba_library_scan_stop(library);
+}
+
+bool gba_library_is_scanning(gba_library_t* library)
+{
+    return library->scan.timer != NULL;
+}
+
+uint32_t gba_library_get_count(gba_library_t* library)
+{
+    return library->entry_num;
+}
+
+const gba_library_entry_t* gba_library_get_entry(gba_library_t* library, uint32_t index)
+{
+    return index < library->entry_num ? &library->entries[index] : NULL;
+}
+
+int32_t gba_library_find_index(gba_library_t* library, const char* rel_path)
+{
+    const gba_library_entry_t* entry = gba_library_find(library, rel_path);
+    return entry ? (int32_t)(entry - library->entries) : -1;
+}
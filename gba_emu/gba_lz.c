@@ -0,0 +1,253 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <string.h>
+
+/*
+ * LZ4 compatible block codec.
+ * No frame format and no external dependency, the callers store the sizes.
+ * Both functions only use libc so they are safe to call from the worker thread.
+ */
+
+#define GBA_LZ_HASH_BITS 12
+#define GBA_LZ_MIN_MATCH 4
+#define GBA_LZ_LAST_LITERALS 5
+#define GBA_LZ_MF_LIMIT 12
+#define GBA_LZ_MAX_OFFSET 65535
+#define GBA_LZ_SKIP_TRIGGER 6
+
+static inline uint32_t gba_lz_read32(const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t gba_lz_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - GBA_LZ_HASH_BITS);
+}
+
+static inline uint8_t* gba_lz_write_length(uint8_t* op, size_t len)
+{
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+static inline size_t gba_lz_sequence_bound(size_t lit_len, size_t match_len)
+{
+    /* token + literal length + literals + offset + match length */
+    return 1 + (lit_len / 255 + 1) + lit_len + 2 + (match_len / 255 + 1);
+}
+
+size_t gba_lz_compress_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+size_t gba_lz_compress(const void* src, size_t src_size, void* dst, size_t dst_capacity)
+{
+    uint32_t table[1 << GBA_LZ_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    const uint8_t* base = src;
+    const uint8_t* ip = base;
+    const uint8_t* anchor = base;
+    const uint8_t* iend = base + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = op + dst_capacity;
+
+    if (src_size > GBA_LZ_MF_LIMIT) {
+        const uint8_t* mflimit = iend - GBA_LZ_MF_LIMIT;
+        const uint8_t* matchlimit = iend - GBA_LZ_LAST_LITERALS;
+        uint32_t misses = 0;
+
+        ip++;
+        while (ip < mflimit) {
+            uint32_t seq = gba_lz_read32(ip);
+            uint32_t h = gba_lz_hash(seq);
+            const uint8_t* ref = base + table[h];
+            table[h] = (uint32_t)(ip - base);
+
+            if (ref >= ip || ip - ref > GBA_LZ_MAX_OFFSET || gba_lz_read32(ref) != seq) {
+                /* Skip faster through data that does not compress */
+                ip += 1 + (misses++ >> GBA_LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            misses = 0;
+
+            while (ip > anchor && ref > base && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            const uint8_t* mp = ip + GBA_LZ_MIN_MATCH;
+            const uint8_t* rp = ref + GBA_LZ_MIN_MATCH;
+            while (mp < matchlimit && *mp == *rp) {
+                mp++;
+                rp++;
+            }
+
+            size_t lit_len = ip - anchor;
+            size_t match_len = mp - ip - GBA_LZ_MIN_MATCH;
+
+            if (gba_lz_sequence_bound(lit_len, match_len) > (size_t)(oend - op)) {
+                return 0;
+            }
+
+            uint8_t* token = op++;
+            if (lit_len >= 15) {
+                *token = 15 << 4;
+                op = gba_lz_write_length(op, lit_len - 15);
+            } else {
+                *token = (uint8_t)(lit_len << 4);
+            }
+
+            memcpy(op, anchor, lit_len);
+            op += lit_len;
+
+            size_t offset = ip - ref;
+            *op++ = (uint8_t)(offset & 0xFF);
+            *op++ = (uint8_t)(offset >> 8);
+
+            if (match_len >= 15) {
+                *token |= 15;
+                op = gba_lz_write_length(op, match_len - 15);
+            } else {
+                *token |= (uint8_t)match_len;
+            }
+
+            ip = mp;
+            anchor = ip;
+
+            /* Seed the table with the end of the match to find the next one sooner */
+            table[gba_lz_hash(gba_lz_read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+        }
+    }
+
+    size_t lit_len = iend - anchor;
+    if (gba_lz_sequence_bound(lit_len, 0) > (size_t)(oend - op)) {
+        return 0;
+    }
+
+    if (lit_len >= 15) {
+        *op++ = 15 << 4;
+        op = gba_lz_write_length(op, lit_len - 15);
+    } else {
+        *op++ = (uint8_t)(lit_len << 4);
+    }
+
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    return op - (uint8_t*)dst;
+}
+
+static inline bool gba_lz_read_length(const uint8_t** ip, const uint8_t* iend, size_t* len)
+{
+    uint8_t b;
+    do {
+        if (*ip >= iend) {
+            return false;
+        }
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+size_t gba_lz_decompress(const void* src, size_t src_size, void* dst, size_t dst_size)
+{
+    const uint8_t* ip = src;
+    const uint8_t* iend = ip + src_size;
+    uint8_t* op = dst;
+    uint8_t* oend = op + dst_size;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !gba_lz_read_length(&ip, iend, &lit_len)) {
+            return 0;
+        }
+
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) {
+            return 0;
+        }
+
+        memcpy(op, ip, lit_len);
+        ip += lit_len;
+        op += lit_len;
+
+        /* The last sequence only carries literals */
+        if (ip >= iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return 0;
+        }
+
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > (size_t)(op - (uint8_t*)dst)) {
+            return 0;
+        }
+
+        size_t match_len = token & 15;
+        if (match_len == 15 && !gba_lz_read_length(&ip, iend, &match_len)) {
+            return 0;
+        }
+        match_len += GBA_LZ_MIN_MATCH;
+
+        if (match_len > (size_t)(oend - op)) {
+            return 0;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= match_len) {
+            memcpy(op, match, match_len);
+            op += match_len;
+        } else if (offset == 1) {
+            memset(op, *match, match_len);
+            op += match_len;
+        } else {
+            /* Overlapped copy, replicate the pattern one period at a time */
+            while (match_len > 0) {
+                size_t n = match_len < offset ? match_len : offset;
+                memcpy(op, match, n);
+                op += n;
+                match += n;
+                match_len -= n;
+            }
+        }
+    }
+
+    return op - (uint8_t*)dst;
+}
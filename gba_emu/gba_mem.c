@@ -0,0 +1,182 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+
+/*
+ * Tagged accounting for the lv_malloc callers of the emulator.
+ * Each block carries a small header with its tag and size, so that
+ * gba_mem_free() needs nothing but the pointer.
+ * Main thread only, like the LVGL heap behind it.
+ */
+#define GBA_MEM_MAGIC 0x47424D4D /* "GBMM" */
+
+typedef union {
+    struct {
+        size_t size;
+        uint32_t tag;
+        uint32_t magic;
+    } info;
+    uint64_t align[2]; /* Keeps the payload aligned like lv_malloc() */
+} gba_mem_header_t;
+
+static lv_gba_mem_stat_t g_mem_stat[_LV_GBA_MEM_TAG_MAX];
+
+static const char* const g_mem_tag_name[_LV_GBA_MEM_TAG_MAX] = {
+    "core",
+    "emu",
+    "state",
+    "io",
+    "menu",
+    "port",
+    "record",
+};
+
+static void gba_mem_add(lv_gba_mem_stat_t* stat, size_t size)
+{
+    stat->cur += size;
+    if (stat->cur > stat->peak) {
+        stat->peak = stat->cur;
+    }
+}
+
+void gba_mem_track(lv_gba_mem_tag_t tag, ptrdiff_t size)
+{
+    LV_ASSERT(tag < _LV_GBA_MEM_TAG_MAX);
+    lv_gba_mem_stat_t* stat = &g_mem_stat[tag];
+
+    if (size >= 0) {
+        gba_mem_add(stat, size);
+        stat->alloc_cnt++;
+    } else {
+        LV_ASSERT((size_t)-size <= stat->cur);
+        stat->cur -= (size_t)-size;
+    }
+}
+
+static void* gba_mem_attach(gba_mem_header_t* header, lv_gba_mem_tag_t tag, size_t size)
+{
+    if (!header) {
+        return NULL;
+    }
+
+    header->info.size = size;
+    header->info.tag = tag;
+    header->info.magic = GBA_MEM_MAGIC;
+    gba_mem_track(tag, size);
+    return header + 1;
+}
+
+static gba_mem_header_t* gba_mem_detach(void* ptr)
+{
+    gba_mem_header_t* header = (gba_mem_header_t*)ptr - 1;
+    LV_ASSERT_MSG(header->info.magic == GBA_MEM_MAGIC, "not allocated by gba_mem_alloc");
+    gba_mem_track(header->info.tag, -(ptrdiff_t)header->info.size);
+    return header;
+}
+
+void* gba_mem_alloc(lv_gba_mem_tag_t tag, size_t size)
+{
+    return gba_mem_attach(lv_malloc(sizeof(gba_mem_header_t) + size), tag, size);
+}
+
+void* gba_mem_alloc_zeroed(lv_gba_mem_tag_t tag, size_t size)
+{
+    return gba_mem_attach(lv_malloc_zeroed(sizeof(gba_mem_header_t) + size), tag, size);
+}
+
+void* gba_mem_realloc(lv_gba_mem_tag_t tag, void* ptr, size_t size)
+{
+    if (!ptr) {
+        return gba_mem_alloc(tag, size);
+    }
+
+    gba_mem_header_t* header = gba_mem_detach(ptr);
+    gba_mem_header_t* new_header = lv_realloc(header, sizeof(gba_mem_header_t) + size);
+    if (!new_header) {
+        /* The old block is still valid, it is not a new allocation */
+        gba_mem_add(&g_mem_stat[header->info.tag], header->info.size);
+        header->info.magic = GBA_MEM_MAGIC;
+        return NULL;
+    }
+
+    return gba_mem_attach(new_header, tag, size);
+}
+
+char* gba_mem_strdup(lv_gba_mem_tag_t tag, const char* str)
+{
+    size_t len = lv_strlen(str) + 1;
+    char* dup = gba_mem_alloc(tag, len);
+    if (dup) {
+        lv_memcpy(dup, str, len);
+    }
+    return dup;
+}
+
+void gba_mem_free(void* ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    gba_mem_header_t* header = gba_mem_detach(ptr);
+    header->info.magic = 0;
+    lv_free(header);
+}
+
+bool gba_mem_get_stat(lv_gba_mem_tag_t tag, lv_gba_mem_stat_t* stat)
+{
+    LV_ASSERT_NULL(stat);
+    if (tag >= _LV_GBA_MEM_TAG_MAX) {
+        return false;
+    }
+
+    *stat = g_mem_stat[tag];
+    return true;
+}
+
+void gba_mem_dump(void)
+{
+    size_t cur = 0;
+    size_t peak = 0;
+
+    for (int i = 0; i < _LV_GBA_MEM_TAG_MAX; i++) {
+        const lv_gba_mem_stat_t* stat = &g_mem_stat[i];
+        LV_LOG_USER("mem %-6s: %8" LV_PRIu32 " KB now, %8" LV_PRIu32 " KB peak, %6" LV_PRIu32 " allocs",
+            g_mem_tag_name[i], (uint32_t)(stat->cur / 1024), (uint32_t)(stat->peak / 1024), stat->alloc_cnt);
+        cur += stat->cur;
+        peak += stat->peak;
+    }
+
+    /* Sum of the peaks: an upper bound, the tags do not peak together */
+    LV_LOG_USER("mem total : %8" LV_PRIu32 " KB now, %8" LV_PRIu32 " KB peak",
+        (uint32_t)(cur / 1024), (uint32_t)(peak / 1024));
+
+#if LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN
+    /* Widgets, styles and images live here, next to the tagged blocks above */
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    LV_LOG_USER("mem lvgl  : %8" LV_PRIu32 " KB used, %8" LV_PRIu32 " KB peak of %" LV_PRIu32 " KB pool, %d%% frag",
+        (uint32_t)((mon.total_size - mon.free_size) / 1024), (uint32_t)(mon.max_used / 1024),
+        (uint32_t)(mon.total_size / 1024), mon.frag_pct);
+#endif
+}
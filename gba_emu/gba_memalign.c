@@ -20,13 +20,17 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-#include "lvgl/lvgl.h"
+#include "gba_internal.h"
 
 void* memalign_alloc(size_t boundary, size_t size)
 {
     void** place = NULL;
     uintptr_t addr = 0;
-    void* ptr = (void*)lv_malloc(boundary + size + sizeof(uintptr_t));
+    void* ptr = gba_arena_alloc(size, boundary);
+    if (ptr)
+        return ptr;
+
+    ptr = gba_mem_alloc(LV_GBA_MEM_TAG_CORE, boundary + size + sizeof(uintptr_t));
     if (!ptr)
         return NULL;
 
@@ -44,13 +48,23 @@ void memalign_free(void* ptr)
     if (!ptr)
         return;
 
+    if (gba_rom_release_buffer(ptr))
+        return;
+
+    if (gba_arena_free(ptr))
+        return;
+
     /* Avoid unalign access */
     lv_memcpy(&original_ptr, (uint8_t*)ptr - sizeof(void*), sizeof(void*));
-    lv_free(original_ptr);
+    gba_mem_free(original_ptr);
 }
 
 void* memalign_alloc_aligned(size_t size)
 {
+    void* rom_buf = gba_rom_claim_buffer(size);
+    if (rom_buf)
+        return rom_buf;
+
 #if defined(__x86_64__) || defined(__LP64) || defined(__IA64__) || defined(_M_X64) || defined(_WIN64)
     return memalign_alloc(64, size);
 #elif defined(__i386__) || defined(__i486__) || defined(__i686__) || defined(GEKKO)
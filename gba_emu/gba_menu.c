@@ -21,54 +21,500 @@
  * SOFTWARE.
  */
 #include "gba_menu.h"
+#include "gba_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Virtualized ROM list: only the rows that fit on screen (plus a margin)
+ * exist as widgets, they are rebound to library entries while scrolling.
+ * The list container is the only focusable object, it handles the keys itself.
+ * A search query filters the list down to the matching entries.
+ */
+#define MENU_ROW_PAD 8
+#define MENU_ROW_MARGIN 2
+#define MENU_ROW_MAX 64
+
+/* Picked with UP/DOWN while searching with a keypad */
+#define MENU_SEARCH_CHARS "abcdefghijklmnopqrstuvwxyz0123456789"
 
 typedef struct {
     char base_path[512];
     gba_menu_select_cb_t cb;
     void* user_data;
+
+    /* Kept across menu instances, returning from a game only checks directory mtimes */
+    gba_library_t* library;
+
+    lv_obj_t* title;
+    lv_obj_t* list;
+    lv_obj_t* filler;
+    lv_obj_t* thumb;
+    lv_image_dsc_t thumb_dsc;
+    lv_obj_t* rows[MENU_ROW_MAX];
+    uint32_t row_num;
+    int32_t row_height;
+    int32_t selected;
+
+    /* Follows the selected ROM when scan results move it to another index */
+    char selected_path[sizeof(((gba_library_entry_t*)0)->path)];
+
+    /* Index rebuilt on the first query after the library changed */
+    gba_search_t* search;
+    bool search_stale;
+    bool editing;
+    char query[GBA_SEARCH_QUERY_MAX];
+    const uint32_t* results;
+    uint32_t result_num;
 } menu_ctx_t;
 
 static menu_ctx_t g_menu_ctx;
 
-static int is_gba_file(const char* filename)
+static uint32_t view_get_count(void)
 {
-    return lv_strcmp(lv_fs_get_ext(filename), "gba") == 0;
+    menu_ctx_t* ctx = &g_menu_ctx;
+    return ctx->query[0] != '\0' ? ctx->result_num : gba_library_get_count(ctx->library);
 }
 
-static void event_handler(lv_event_t* e)
+static const gba_library_entry_t* view_get_entry(int32_t index)
 {
-    lv_event_code_t code = lv_event_get_code(e);
-    lv_obj_t* btn = lv_event_get_target(e);
+    menu_ctx_t* ctx = &g_menu_ctx;
+    if (index < 0 || (uint32_t)index >= view_get_count())
+        return NULL;
 
-    if (code == LV_EVENT_CLICKED) {
-        lv_obj_t* label = lv_obj_get_child(btn, 0);
-        if (!label)
-            return;
+    return gba_library_get_entry(ctx->library, ctx->query[0] != '\0' ? ctx->results[index] : (uint32_t)index);
+}
 
-        const char* filename = lv_label_get_text(label);
-        if (!filename)
-            return;
+static int index_cmp(const void* a, const void* b)
+{
+    uint32_t ia = *(const uint32_t*)a;
+    uint32_t ib = *(const uint32_t*)b;
+    return ia < ib ? -1 : ia > ib;
+}
+
+static int32_t view_find(const char* path)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    int32_t index = gba_library_find_index(ctx->library, path);
+    if (index < 0 || ctx->query[0] == '\0')
+        return index;
 
-        char full_path[1024];
-        lv_snprintf(full_path, sizeof(full_path), "%s/%s", g_menu_ctx.base_path, filename);
+    /* Results are in library order */
+    uint32_t key = index;
+    const uint32_t* found = bsearch(&key, ctx->results, ctx->result_num, sizeof(uint32_t), index_cmp);
+    return found ? (int32_t)(found - ctx->results) : -1;
+}
 
-        if (g_menu_ctx.cb) {
-            g_menu_ctx.cb(full_path, g_menu_ctx.user_data);
+static bool get_entry_path(int32_t index, char* full_path, size_t len)
+{
+    const gba_library_entry_t* entry = view_get_entry(index);
+    if (!entry)
+        return false;
+
+    lv_snprintf(full_path, len, "%s/%s", g_menu_ctx.base_path, entry->path);
+    return true;
+}
+
+static void update_rows(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    int32_t count = view_get_count();
+    int32_t first = lv_obj_get_scroll_y(ctx->list) / ctx->row_height - MENU_ROW_MARGIN / 2;
+    if (first < 0)
+        first = 0;
+
+    for (uint32_t i = 0; i < ctx->row_num; i++) {
+        lv_obj_t* row = ctx->rows[i];
+        lv_obj_t* label = lv_obj_get_child(row, 0);
+        int32_t index = first + i;
+
+        if (index >= count) {
+            lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+            continue;
         }
-    } else if (code == LV_EVENT_FOCUSED) {
-        lv_obj_t* label = lv_obj_get_child(btn, 0);
-        if (label) {
-            lv_label_set_long_mode(label, LV_LABEL_LONG_SCROLL_CIRCULAR);
+
+        /* Only touch the label when the row is bound to another entry */
+        if ((intptr_t)lv_obj_get_user_data(row) != index || lv_obj_has_flag(row, LV_OBJ_FLAG_HIDDEN)) {
+            const gba_library_entry_t* entry = view_get_entry(index);
+            lv_obj_set_user_data(row, (void*)(intptr_t)index);
+            lv_obj_set_y(row, index * ctx->row_height);
+            lv_label_set_text(label, entry->path);
+            lv_obj_remove_flag(row, LV_OBJ_FLAG_HIDDEN);
         }
-    } else if (code == LV_EVENT_DEFOCUSED) {
-        lv_obj_t* label = lv_obj_get_child(btn, 0);
-        if (label) {
-            lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+
+        bool selected = index == ctx->selected;
+        if (selected != lv_obj_has_state(row, LV_STATE_CHECKED)) {
+            lv_obj_set_state(row, LV_STATE_CHECKED, selected);
+            lv_label_set_long_mode(label, selected ? LV_LABEL_LONG_SCROLL_CIRCULAR : LV_LABEL_LONG_DOT);
         }
     }
 }
 
-void gba_menu_create(lv_obj_t* parent, const char* dir_path, gba_menu_select_cb_t cb, void* user_data)
+static void scroll_to_selected(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    /* Keep the selected row inside the viewport */
+    int32_t view_height = lv_obj_get_content_height(ctx->list);
+    int32_t scroll_y = lv_obj_get_scroll_y(ctx->list);
+    int32_t row_top = ctx->selected * ctx->row_height;
+
+    if (row_top < scroll_y) {
+        lv_obj_scroll_to_y(ctx->list, row_top, LV_ANIM_OFF);
+    } else if (row_top + ctx->row_height > scroll_y + view_height) {
+        lv_obj_scroll_to_y(ctx->list, row_top + ctx->row_height - view_height, LV_ANIM_OFF);
+    }
+
+    update_rows();
+}
+
+static void update_thumb(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    const gba_library_entry_t* entry = view_get_entry(ctx->selected);
+
+    /* Straight from the cache mapping, nothing is decoded */
+    const uint16_t* pixels = entry ? gba_thumb_get(entry->crc32, entry->size) : NULL;
+    if (!pixels) {
+        lv_obj_add_flag(ctx->thumb, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    lv_image_cache_drop(&ctx->thumb_dsc);
+    ctx->thumb_dsc.data = (const uint8_t*)pixels;
+    lv_image_set_src(ctx->thumb, &ctx->thumb_dsc);
+    lv_obj_remove_flag(ctx->thumb, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void select_entry(int32_t index)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    int32_t count = view_get_count();
+    if (count == 0) {
+        /* Nothing matches, the selected path is kept for when the query changes back */
+        ctx->selected = -1;
+        update_rows();
+        update_thumb();
+        return;
+    }
+
+    index = LV_CLAMP(0, index, count - 1);
+    if (index == ctx->selected)
+        return;
+
+    ctx->selected = index;
+    lv_strlcpy(ctx->selected_path, view_get_entry(index)->path, sizeof(ctx->selected_path));
+    scroll_to_selected();
+    update_thumb();
+
+    /* Supersedes the prefetch of the previously selected ROM */
+    char full_path[1024];
+    if (get_entry_path(index, full_path, sizeof(full_path))) {
+        gba_prefetch_start(full_path);
+    }
+}
+
+static void update_title(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    if (ctx->editing) {
+        lv_label_set_text_fmt(ctx->title, "Search: %s_ (%" LV_PRIu32 ")", ctx->query, view_get_count());
+    } else if (ctx->query[0] != '\0') {
+        lv_label_set_text_fmt(ctx->title, "Filter: %s (%" LV_PRIu32 ")", ctx->query, view_get_count());
+    } else if (gba_library_is_scanning(ctx->library)) {
+        lv_label_set_text_fmt(ctx->title, "Select ROM (scanning, %" LV_PRIu32 " found)",
+            gba_library_get_count(ctx->library));
+    } else if (gba_library_get_count(ctx->library) == 0) {
+        lv_label_set_text(ctx->title, "No .gba files found");
+    } else {
+        lv_label_set_text(ctx->title, "Select ROM");
+    }
+}
+
+static void update_extent(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    uint32_t count = view_get_count();
+
+    /* Sets the scrollable height without a widget per entry */
+    if (count > 0) {
+        lv_obj_set_y(ctx->filler, count * ctx->row_height - 1);
+        lv_obj_remove_flag(ctx->filler, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_add_flag(ctx->filler, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void update_view(int32_t fallback)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    update_extent();
+    update_title();
+
+    /* Entries were inserted or removed, every row is bound again */
+    for (uint32_t i = 0; i < ctx->row_num; i++) {
+        lv_obj_set_user_data(ctx->rows[i], (void*)(intptr_t)-1);
+    }
+
+    int32_t index = ctx->selected_path[0] != '\0' ? view_find(ctx->selected_path) : -1;
+    if (index >= 0) {
+        /* Same ROM, its prefetch keeps going */
+        ctx->selected = index;
+        scroll_to_selected();
+        update_thumb();
+    } else {
+        ctx->selected = -1;
+        update_rows();
+        select_entry(fallback);
+    }
+}
+
+static void apply_query(void)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    if (ctx->query[0] != '\0') {
+        if (ctx->search_stale) {
+            gba_search_build(ctx->search, ctx->library);
+            ctx->search_stale = false;
+        }
+        ctx->result_num = gba_search_query(ctx->search, ctx->query, &ctx->results);
+    }
+
+    update_view(0);
+}
+
+static bool search_key_handler(uint32_t key)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+    size_t len = lv_strlen(ctx->query);
+    bool printable = key >= ' ' && key < 0x7F;
+
+    if (!ctx->editing) {
+        /* Typing on a keyboard starts searching right away */
+        if (printable && key != ' ') {
+            ctx->editing = true;
+        } else if (key == LV_KEY_ESC && len > 0) {
+            ctx->query[0] = '\0';
+            apply_query();
+            return true;
+        } else if (key == LV_KEY_ESC || key == LV_KEY_BACKSPACE) {
+            ctx->editing = true;
+            update_title();
+            return true;
+        } else {
+            return false;
+        }
+    }
+
+    if (printable) {
+        if (len + 1 < sizeof(ctx->query)) {
+            ctx->query[len] = (char)key;
+            ctx->query[len + 1] = '\0';
+        }
+    } else if (key == LV_KEY_UP || key == LV_KEY_DOWN) {
+        /* Cycles the last character, starting one if there is none */
+        const char* chars = MENU_SEARCH_CHARS;
+        int32_t num = sizeof(MENU_SEARCH_CHARS) - 1;
+        if (len == 0) {
+            ctx->query[len++] = chars[num - 1];
+            ctx->query[len] = '\0';
+        }
+
+        char c = ctx->query[len - 1];
+        const char* pos = strchr(chars, c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+        int32_t i = pos ? pos - chars : 0;
+        ctx->query[len - 1] = chars[(i + (key == LV_KEY_UP ? 1 : num - 1)) % num];
+    } else if (key == LV_KEY_RIGHT) {
+        if (len + 1 < sizeof(ctx->query)) {
+            ctx->query[len] = 'a';
+            ctx->query[len + 1] = '\0';
+        }
+    } else if (key == LV_KEY_LEFT || key == LV_KEY_BACKSPACE) {
+        if (len > 0) {
+            ctx->query[len - 1] = '\0';
+        }
+    } else if (key == LV_KEY_ESC) {
+        ctx->query[0] = '\0';
+        ctx->editing = false;
+    } else {
+        return false;
+    }
+
+    apply_query();
+    return true;
+}
+
+static void library_update_cb(gba_library_t* library, bool done, void* user_data)
+{
+    LV_UNUSED(user_data);
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    if (!ctx->list) {
+        return;
+    }
+
+    ctx->search_stale = true;
+    if (ctx->query[0] != '\0') {
+        apply_query();
+    } else {
+        update_view(LV_MAX(ctx->selected, 0));
+    }
+
+    if (done) {
+        LV_LOG_USER("menu: %" LV_PRIu32 " ROMs listed", gba_library_get_count(library));
+    }
+}
+
+static void activate_entry(int32_t index)
+{
+    char full_path[1024];
+    if (!get_entry_path(index, full_path, sizeof(full_path)))
+        return;
+
+    /* Whatever is already in the page cache stays there */
+    gba_prefetch_cancel();
+
+    if (g_menu_ctx.cb) {
+        g_menu_ctx.cb(full_path, g_menu_ctx.user_data);
+    }
+}
+
+static void row_event_handler(lv_event_t* e)
+{
+    lv_obj_t* row = lv_event_get_target(e);
+    int32_t index = (intptr_t)lv_obj_get_user_data(row);
+
+    select_entry(index);
+    activate_entry(index);
+}
+
+static void list_event_handler(lv_event_t* e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    if (code == LV_EVENT_SCROLL) {
+        update_rows();
+    } else if (code == LV_EVENT_KEY) {
+        uint32_t key = lv_event_get_key(e);
+        if (search_key_handler(key)) {
+            return;
+        }
+
+        if (key == LV_KEY_UP || key == LV_KEY_LEFT) {
+            select_entry(ctx->selected - 1);
+        } else if (key == LV_KEY_DOWN || key == LV_KEY_RIGHT) {
+            select_entry(ctx->selected + 1);
+        } else if (key == LV_KEY_HOME) {
+            select_entry(0);
+        } else if (key == LV_KEY_END) {
+            select_entry(view_get_count() - 1);
+        }
+    } else if (code == LV_EVENT_CLICKED) {
+        /* Touch clicks land on the rows, this is ENTER from a keypad or encoder */
+        lv_indev_t* indev = lv_indev_active();
+        if (indev && lv_indev_get_type(indev) != LV_INDEV_TYPE_POINTER) {
+            if (ctx->editing) {
+                /* Done typing, the results stay filtered */
+                ctx->editing = false;
+                update_title();
+            } else {
+                activate_entry(ctx->selected);
+            }
+        }
+    } else if (code == LV_EVENT_DELETE) {
+        /* Leaving the menu, the directories scanned so far are kept in the index */
+        gba_library_cancel(ctx->library);
+        gba_search_delete(ctx->search);
+        ctx->search = NULL;
+        ctx->results = NULL;
+        ctx->list = NULL;
+        ctx->row_num = 0;
+    }
+}
+
+static lv_obj_t* create_list(lv_obj_t* parent)
+{
+    menu_ctx_t* ctx = &g_menu_ctx;
+
+    lv_obj_t* list = lv_obj_create(parent);
+    lv_obj_set_width(list, LV_PCT(100));
+    lv_obj_set_flex_grow(list, 1);
+    lv_obj_set_style_pad_all(list, 0, 0);
+    lv_obj_set_style_border_width(list, 0, 0);
+    lv_obj_set_style_radius(list, 0, 0);
+    lv_obj_set_scroll_dir(list, LV_DIR_VER);
+    lv_obj_remove_flag(list, LV_OBJ_FLAG_SCROLL_WITH_ARROW);
+    lv_obj_add_event(list, list_event_handler, LV_EVENT_ALL, NULL);
+
+    const lv_font_t* font = lv_obj_get_style_text_font(list, 0);
+    ctx->row_height = lv_font_get_line_height(font) + 2 * MENU_ROW_PAD;
+    ctx->selected = -1;
+    ctx->selected_path[0] = '\0';
+
+    ctx->search = gba_search_create();
+    ctx->search_stale = true;
+    ctx->editing = false;
+    ctx->query[0] = '\0';
+    ctx->result_num = 0;
+
+    ctx->filler = lv_obj_create(list);
+    lv_obj_remove_style_all(ctx->filler);
+    lv_obj_set_size(ctx->filler, 1, 1);
+    lv_obj_remove_flag(ctx->filler, LV_OBJ_FLAG_CLICKABLE);
+
+    /* Rows for a full viewport, the scan may still add entries */
+    lv_obj_update_layout(parent);
+    uint32_t row_num = lv_obj_get_content_height(list) / ctx->row_height + 1 + MENU_ROW_MARGIN;
+    ctx->row_num = LV_MIN(row_num, MENU_ROW_MAX);
+
+    for (uint32_t i = 0; i < ctx->row_num; i++) {
+        lv_obj_t* row = lv_button_create(list);
+        lv_obj_set_size(row, LV_PCT(100), ctx->row_height);
+        lv_obj_set_style_radius(row, 0, 0);
+        lv_obj_set_style_pad_hor(row, MENU_ROW_PAD, 0);
+        lv_obj_set_style_pad_ver(row, 0, 0);
+        lv_obj_set_style_shadow_width(row, 0, 0);
+        lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_set_user_data(row, (void*)(intptr_t)-1);
+        lv_obj_add_event(row, row_event_handler, LV_EVENT_CLICKED, NULL);
+
+        /* The list keeps the focus, rows are only for touch */
+        lv_group_remove_obj(row);
+
+        lv_obj_t* label = lv_label_create(row);
+        lv_obj_set_width(label, LV_PCT(100));
+        lv_obj_align(label, LV_ALIGN_LEFT_MID, 0, 0);
+        lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
+
+        ctx->rows[i] = row;
+    }
+
+    /* Preview of the selected ROM, over the bottom right corner of the list */
+    ctx->thumb = lv_image_create(parent);
+    lv_obj_add_flag(ctx->thumb, LV_OBJ_FLAG_FLOATING | LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_style_border_width(ctx->thumb, 2, 0);
+    lv_obj_set_style_border_color(ctx->thumb, lv_theme_get_color_primary(ctx->thumb), 0);
+    lv_obj_align(ctx->thumb, LV_ALIGN_BOTTOM_RIGHT, -MENU_ROW_PAD, -MENU_ROW_PAD);
+
+    lv_image_dsc_t* dsc = &ctx->thumb_dsc;
+    lv_memzero(dsc, sizeof(lv_image_dsc_t));
+    dsc->header.magic = LV_IMAGE_HEADER_MAGIC;
+    dsc->header.cf = LV_COLOR_FORMAT_RGB565;
+    dsc->header.w = GBA_THUMB_WIDTH;
+    dsc->header.h = GBA_THUMB_HEIGHT;
+    dsc->header.stride = GBA_THUMB_WIDTH * sizeof(uint16_t);
+    dsc->data_size = GBA_THUMB_WIDTH * GBA_THUMB_HEIGHT * sizeof(uint16_t);
+
+    ctx->list = list;
+    update_extent();
+    return list;
+}
+
+lv_obj_t* gba_menu_create(lv_obj_t* parent, const char* dir_path, gba_menu_select_cb_t cb, void* user_data)
 {
     char fs_path[512];
     if (dir_path[0] != '/') {
@@ -77,53 +523,55 @@ void gba_menu_create(lv_obj_t* parent, const char* dir_path, gba_menu_select_cb_
         lv_snprintf(fs_path, sizeof(fs_path), "%s", dir_path);
     }
 
+    if (g_menu_ctx.library && lv_strcmp(g_menu_ctx.base_path, fs_path) != 0) {
+        gba_library_close(g_menu_ctx.library);
+        g_menu_ctx.library = NULL;
+    }
+
+    if (!g_menu_ctx.library) {
+        g_menu_ctx.library = gba_library_open(fs_path);
+    }
+
     lv_strlcpy(g_menu_ctx.base_path, fs_path, sizeof(g_menu_ctx.base_path));
     g_menu_ctx.cb = cb;
     g_menu_ctx.user_data = user_data;
 
-    lv_obj_t* list = lv_list_create(parent);
-    lv_obj_set_style_clip_corner(list, false, 0);
-    lv_obj_set_style_text_font(list, &lv_font_source_han_sans_sc_16_cjk, 0);
-    lv_obj_set_size(list, LV_PCT(100), LV_PCT(100));
-    lv_obj_center(list);
-
-    lv_list_add_text(list, "Select ROM");
-
-    lv_fs_dir_t dir;
-    lv_fs_res_t res;
-    res = lv_fs_dir_open(&dir, fs_path);
-
-    int count = 0;
-    if (res == LV_FS_RES_OK) {
-        char fn[256];
-        while (1) {
-            res = lv_fs_dir_read(&dir, fn, sizeof(fn));
-            if (res != LV_FS_RES_OK || fn[0] == '\0')
-                break;
-
-            if (fn[0] == '/')
-                continue;
-
-            if (is_gba_file(fn)) {
-                lv_obj_t* btn = lv_list_add_btn(list, NULL, fn);
-                lv_obj_add_event(btn, event_handler, LV_EVENT_CLICKED, NULL);
-                lv_obj_add_event(btn, event_handler, LV_EVENT_FOCUSED, NULL);
-                lv_obj_add_event(btn, event_handler, LV_EVENT_DEFOCUSED, NULL);
-                
-                lv_obj_t* label = lv_obj_get_child(btn, 0);
-                if (label) {
-                    lv_label_set_long_mode(label, LV_LABEL_LONG_DOT);
-                }
-                count++;
-            }
-        }
-        lv_fs_dir_close(&dir);
-    } else {
-        lv_list_add_text(list, "Failed to open directory:");
-        lv_list_add_text(list, fs_path);
+    lv_obj_t* cont = lv_list_create(parent);
+    lv_obj_set_style_clip_corner(cont, false, 0);
+    lv_obj_set_style_text_font(cont, &lv_font_source_han_sans_sc_16_cjk, 0);
+    lv_obj_set_size(cont, LV_PCT(100), LV_PCT(100));
+    lv_obj_center(cont);
+
+    g_menu_ctx.title = lv_list_add_text(cont, "Select ROM");
+
+    /* Entries stored in the index are listed right away, the scan updates them */
+    gba_library_t* library = g_menu_ctx.library;
+    if (!library || !gba_library_refresh(library, library_update_cb, NULL)) {
+        lv_list_add_text(cont, "Failed to open directory:");
+        lv_list_add_text(cont, fs_path);
+        return cont;
     }
 
-    if (count == 0 && res == LV_FS_RES_OK) {
-        lv_list_add_text(list, "No .gba files found");
+    gba_thumb_set_dir(fs_path);
+
+    uint64_t start = gba_tick_us_get();
+    lv_obj_t* list = create_list(cont);
+
+    lv_group_t* group = lv_group_get_default();
+    if (group) {
+        lv_group_add_obj(group, list);
+        lv_group_focus_obj(list);
+
+        /* An encoder (mouse wheel) then sends LEFT/RIGHT to the list instead of moving the focus */
+        lv_group_set_editing(group, true);
     }
+
+    update_title();
+    update_rows();
+    select_entry(0);
+
+    LV_LOG_USER("menu: %" LV_PRIu32 " rows for %" LV_PRIu32 " ROMs created in %" LV_PRIu32 " us",
+        g_menu_ctx.row_num, gba_library_get_count(library), (uint32_t)(gba_tick_us_get() - start));
+
+    return cont;
 }
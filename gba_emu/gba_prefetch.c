@@ -0,0 +1,229 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Warms up the page cache for the ROM under the menu cursor, so the
+ * synchronous load after the click is served from memory.
+ * Each chunk is read for real, the request is checked between chunks and
+ * a new focus cancels the old one.
+ */
+#define GBA_PREFETCH_CHUNK_SIZE (128 * 1024)
+
+typedef struct {
+    pthread_mutex_t mutex;
+    gba_worker_job_t job;
+    bool running;
+
+    /* Bumped on every request, the worker drops a file as soon as it changes */
+    uint32_t generation;
+    char rom_path[256];
+    char save_path[256];
+
+    /* Progress of the current request, for the log */
+    size_t done_bytes;
+    size_t total_bytes;
+    uint64_t start_tick;
+
+    /* Only touched by the worker, the data itself is dropped */
+    uint8_t scratch[GBA_PREFETCH_CHUNK_SIZE];
+} gba_prefetch_t;
+
+static gba_prefetch_t g_prefetch = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static bool gba_prefetch_is_current(gba_prefetch_t* prefetch, uint32_t generation)
+{
+    pthread_mutex_lock(&prefetch->mutex);
+    bool current = prefetch->generation == generation;
+    pthread_mutex_unlock(&prefetch->mutex);
+    return current;
+}
+
+static void gba_prefetch_file(gba_prefetch_t* prefetch, const char* path, uint32_t generation)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+
+    pthread_mutex_lock(&prefetch->mutex);
+    if (prefetch->generation == generation) {
+        prefetch->total_bytes += st.st_size;
+    }
+    pthread_mutex_unlock(&prefetch->mutex);
+
+    /*
+     * pread() fills the page cache with small folios, and a ROM mapping
+     * keeps those. A ROM that will get huge pages is warmed through a
+     * mapping with the same hint instead, so its folios are 2 MB too.
+     */
+    uint8_t* map = NULL;
+#ifdef MADV_HUGEPAGE
+    if (gba_rom_want_hugepage(path, st.st_size)) {
+        map = gba_rom_mmap(fd, st.st_size, PROT_READ);
+        if (map && madvise(map, st.st_size, MADV_HUGEPAGE) != 0) {
+            munmap(map, st.st_size);
+            map = NULL;
+        }
+    }
+#endif
+
+    long page_size = sysconf(_SC_PAGESIZE);
+    off_t offset = 0;
+    while (offset < st.st_size) {
+        if (!gba_prefetch_is_current(prefetch, generation)) {
+            break;
+        }
+
+        /*
+         * POSIX_FADV_WILLNEED only queues the readahead and returns at once,
+         * the chunk is in the page cache when this read or fault returns.
+         */
+        ssize_t len;
+        if (map) {
+            len = LV_MIN(st.st_size - offset, GBA_PREFETCH_CHUNK_SIZE);
+            for (off_t i = 0; i < len; i += page_size) {
+                prefetch->scratch[0] = ((volatile uint8_t*)map)[offset + i];
+            }
+        } else {
+            len = pread(fd, prefetch->scratch, sizeof(prefetch->scratch), offset);
+            if (len <= 0) {
+                break;
+            }
+        }
+
+        offset += len;
+
+        pthread_mutex_lock(&prefetch->mutex);
+        if (prefetch->generation == generation) {
+            prefetch->done_bytes += len;
+        }
+        pthread_mutex_unlock(&prefetch->mutex);
+    }
+
+    if (map) {
+        munmap(map, st.st_size);
+    }
+    close(fd);
+}
+
+static void gba_prefetch_job_cb(void* user_data)
+{
+    gba_prefetch_t* prefetch = user_data;
+    char rom_path[256];
+    char save_path[256];
+
+    pthread_mutex_lock(&prefetch->mutex);
+    while (prefetch->rom_path[0] != '\0') {
+        uint32_t generation = prefetch->generation;
+        lv_strlcpy(rom_path, prefetch->rom_path, sizeof(rom_path));
+        lv_strlcpy(save_path, prefetch->save_path, sizeof(save_path));
+        pthread_mutex_unlock(&prefetch->mutex);
+
+        gba_prefetch_file(prefetch, save_path, generation);
+        gba_prefetch_file(prefetch, rom_path, generation);
+
+        pthread_mutex_lock(&prefetch->mutex);
+
+        /* Finished: stay idle until the next request */
+        if (prefetch->generation == generation) {
+            prefetch->rom_path[0] = '\0';
+        }
+    }
+    prefetch->running = false;
+    pthread_mutex_unlock(&prefetch->mutex);
+}
+
+void gba_prefetch_start(const char* path)
+{
+    LV_ASSERT_NULL(path);
+    gba_prefetch_t* prefetch = &g_prefetch;
+
+    char save_path[256];
+    gba_retro_get_save_path(save_path, sizeof(save_path), path);
+
+    pthread_mutex_lock(&prefetch->mutex);
+    prefetch->generation++;
+    gba_fs_get_native_path(prefetch->rom_path, sizeof(prefetch->rom_path), path);
+    gba_fs_get_native_path(prefetch->save_path, sizeof(prefetch->save_path), save_path);
+    prefetch->done_bytes = 0;
+    prefetch->total_bytes = 0;
+    prefetch->start_tick = gba_tick_us_get();
+
+    /* A running job picks up the new path by itself */
+    bool submit = !prefetch->running;
+    prefetch->running = true;
+    pthread_mutex_unlock(&prefetch->mutex);
+
+    if (!submit) {
+        return;
+    }
+
+    if (prefetch->job.cb == NULL) {
+        gba_worker_job_init(&prefetch->job, gba_prefetch_job_cb, prefetch);
+    }
+
+    /* The previous job may not have returned to the worker yet */
+    if (!gba_worker_submit(&prefetch->job)) {
+        gba_worker_wait(&prefetch->job);
+        if (!gba_worker_submit(&prefetch->job)) {
+            pthread_mutex_lock(&prefetch->mutex);
+            prefetch->running = false;
+            pthread_mutex_unlock(&prefetch->mutex);
+        }
+    }
+}
+
+void gba_prefetch_cancel(void)
+{
+    gba_prefetch_t* prefetch = &g_prefetch;
+
+    pthread_mutex_lock(&prefetch->mutex);
+    size_t done_bytes = prefetch->done_bytes;
+    size_t total_bytes = prefetch->total_bytes;
+    uint32_t elapsed_ms = (gba_tick_us_get() - prefetch->start_tick) / 1000;
+
+    prefetch->generation++;
+    prefetch->rom_path[0] = '\0';
+    prefetch->total_bytes = 0;
+    prefetch->done_bytes = 0;
+    pthread_mutex_unlock(&prefetch->mutex);
+
+    if (total_bytes > 0) {
+        LV_LOG_USER("prefetch: %zu / %zu KB warmed in %" LV_PRIu32 " ms",
+            done_bytes / 1024, total_bytes / 1024, elapsed_ms);
+    }
+}
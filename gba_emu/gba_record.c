@@ -0,0 +1,541 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+
+#if HAVE_NEON
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Frames in flight between the emulation thread and the worker */
+#ifndef GBA_RECORD_SLOT_NUM
+#define GBA_RECORD_SLOT_NUM 8
+#endif
+
+/* Stereo frames buffered per video frame, ~7 frames at 32768 Hz */
+#ifndef GBA_RECORD_AUDIO_FRAMES_MAX
+#define GBA_RECORD_AUDIO_FRAMES_MAX 4096
+#endif
+
+#define GBA_RECORD_WAV_HEADER_SIZE 44
+
+typedef struct {
+    gba_worker_job_t job;
+    gba_record_t* record;
+    uint16_t* pixels; /* Frame without the stride padding */
+    uint8_t* yuv; /* I420, converted by the worker */
+    int16_t* audio;
+    uint32_t audio_frames;
+    uint32_t repeat; /* Frames dropped before this one, written again to keep A/V sync */
+} gba_record_slot_t;
+
+struct gba_record_s {
+    gba_record_slot_t slots[GBA_RECORD_SLOT_NUM];
+    uint32_t slot_index;
+
+    /* Audio of the frame being emulated */
+    int16_t* audio;
+    uint32_t audio_frames;
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t sample_rate;
+    uint32_t repeat_pending;
+
+    FILE* video_fp;
+    bool video_pipe;
+    FILE* audio_fp;
+
+    /* Only touched by the worker until every slot is idle */
+    bool failed;
+    uint32_t written;
+    uint32_t converted;
+    uint64_t audio_bytes;
+    uint64_t convert_us;
+
+    struct {
+        uint32_t frames;
+        uint32_t dropped;
+        uint32_t audio_dropped;
+    } stat;
+};
+
+static inline uint8_t gba_record_y(int r, int g, int b)
+{
+    return (77 * r + 150 * g + 29 * b + 128) >> 8;
+}
+
+/* The average is 0 ~ 255 per channel, so the chroma products fit 16-bit lanes */
+static inline uint8_t gba_record_u(int r, int g, int b)
+{
+    return ((-43 * r - 85 * g + 128 * b) >> 8) + 128;
+}
+
+static inline uint8_t gba_record_v(int r, int g, int b)
+{
+    return ((128 * r - 107 * g - 21 * b) >> 8) + 128;
+}
+
+/*
+ * BT.601 full range (C420jpeg), chroma is taken from the rounded average of
+ * each 2x2 block. The vector paths convert 16x2 pixels per iteration and
+ * give the same bytes as the scalar one, which also handles the remainder.
+ */
+static void gba_record_convert(uint8_t* restrict yuv, const uint16_t* restrict src, uint32_t width, uint32_t height)
+{
+    uint8_t* y_plane = yuv;
+    uint8_t* u_plane = y_plane + width * height;
+    uint8_t* v_plane = u_plane + (width / 2) * (height / 2);
+
+    for (uint32_t y = 0; y < height; y += 2) {
+        const uint16_t* restrict row0 = src + y * width;
+        const uint16_t* restrict row1 = row0 + width;
+        uint8_t* restrict y0 = y_plane + y * width;
+        uint8_t* restrict y1 = y0 + width;
+        uint8_t* restrict u = u_plane + (y / 2) * (width / 2);
+        uint8_t* restrict v = v_plane + (y / 2) * (width / 2);
+        uint32_t x = 0;
+
+#if HAVE_NEON
+        const uint16x8_t mask6 = vdupq_n_u16(0x3F);
+        const uint16x8_t mask5 = vdupq_n_u16(0x1F);
+        const int16x8_t bias = vdupq_n_s16(128);
+
+        for (; x + 8 <= width / 2; x += 8) {
+            /* Even and odd pixels in separate vectors, the pairs line up lane by lane */
+            uint16x8x2_t p[2] = { vld2q_u16(row0 + x * 2), vld2q_u16(row1 + x * 2) };
+            uint16x8_t r_sum = vdupq_n_u16(0);
+            uint16x8_t g_sum = vdupq_n_u16(0);
+            uint16x8_t b_sum = vdupq_n_u16(0);
+
+            for (int i = 0; i < 4; i++) {
+                uint16x8_t c = p[i >> 1].val[i & 1];
+                uint16x8_t r = vshrq_n_u16(c, 11);
+                uint16x8_t g = vandq_u16(vshrq_n_u16(c, 5), mask6);
+                uint16x8_t b = vandq_u16(c, mask5);
+                r = vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2));
+                g = vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4));
+                b = vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2));
+
+                uint16x8_t luma = vmlaq_n_u16(vmlaq_n_u16(vmlaq_n_u16(vdupq_n_u16(128), r, 77), g, 150), b, 29);
+                p[i >> 1].val[i & 1] = vshrq_n_u16(luma, 8);
+                r_sum = vaddq_u16(r_sum, r);
+                g_sum = vaddq_u16(g_sum, g);
+                b_sum = vaddq_u16(b_sum, b);
+            }
+
+            uint8x8x2_t luma0 = { { vmovn_u16(p[0].val[0]), vmovn_u16(p[0].val[1]) } };
+            uint8x8x2_t luma1 = { { vmovn_u16(p[1].val[0]), vmovn_u16(p[1].val[1]) } };
+            vst2_u8(y0 + x * 2, luma0);
+            vst2_u8(y1 + x * 2, luma1);
+
+            int16x8_t r = vreinterpretq_s16_u16(vrshrq_n_u16(r_sum, 2));
+            int16x8_t g = vreinterpretq_s16_u16(vrshrq_n_u16(g_sum, 2));
+            int16x8_t b = vreinterpretq_s16_u16(vrshrq_n_u16(b_sum, 2));
+
+            int16x8_t cb = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, -43), g, -85), b, 128);
+            int16x8_t cr = vmlaq_n_s16(vmlaq_n_s16(vmulq_n_s16(r, 128), g, -107), b, -21);
+            vst1_u8(u + x, vqmovun_s16(vaddq_s16(vshrq_n_s16(cb, 8), bias)));
+            vst1_u8(v + x, vqmovun_s16(vaddq_s16(vshrq_n_s16(cr, 8), bias)));
+        }
+#elif defined(__SSE2__)
+        const __m128i mask6 = _mm_set1_epi16(0x3F);
+        const __m128i mask5 = _mm_set1_epi16(0x1F);
+        const __m128i one = _mm_set1_epi16(1);
+        const __m128i two = _mm_set1_epi16(2);
+        const __m128i bias = _mm_set1_epi16(128);
+
+        for (; x + 8 <= width / 2; x += 8) {
+            __m128i r_sum[2], g_sum[2], b_sum[2];
+
+            /* Vector j holds pixels 8j ~ 8j+7 of both rows, the pairs are summed after */
+            for (int j = 0; j < 2; j++) {
+                __m128i luma[2];
+
+                for (int i = 0; i < 2; i++) {
+                    __m128i c = _mm_loadu_si128((const __m128i*)((i ? row1 : row0) + x * 2 + j * 8));
+                    __m128i r = _mm_srli_epi16(c, 11);
+                    __m128i g = _mm_and_si128(_mm_srli_epi16(c, 5), mask6);
+                    __m128i b = _mm_and_si128(c, mask5);
+                    r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+                    g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+                    b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+
+                    /* At most 65408, the unsigned shift keeps the top bit */
+                    luma[i] = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+                                                               _mm_mullo_epi16(r, _mm_set1_epi16(77)),
+                                                               _mm_mullo_epi16(g, _mm_set1_epi16(150))),
+                                                 _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(29)), bias)),
+                        8);
+
+                    r_sum[j] = i ? _mm_add_epi16(r_sum[j], r) : r;
+                    g_sum[j] = i ? _mm_add_epi16(g_sum[j], g) : g;
+                    b_sum[j] = i ? _mm_add_epi16(b_sum[j], b) : b;
+                }
+
+                _mm_storel_epi64((__m128i*)(y0 + x * 2 + j * 8), _mm_packus_epi16(luma[0], luma[0]));
+                _mm_storel_epi64((__m128i*)(y1 + x * 2 + j * 8), _mm_packus_epi16(luma[1], luma[1]));
+            }
+
+            __m128i r = _mm_packs_epi32(_mm_madd_epi16(r_sum[0], one), _mm_madd_epi16(r_sum[1], one));
+            __m128i g = _mm_packs_epi32(_mm_madd_epi16(g_sum[0], one), _mm_madd_epi16(g_sum[1], one));
+            __m128i b = _mm_packs_epi32(_mm_madd_epi16(b_sum[0], one), _mm_madd_epi16(b_sum[1], one));
+            r = _mm_srli_epi16(_mm_add_epi16(r, two), 2);
+            g = _mm_srli_epi16(_mm_add_epi16(g, two), 2);
+            b = _mm_srli_epi16(_mm_add_epi16(b, two), 2);
+
+            __m128i cb = _mm_add_epi16(_mm_add_epi16(
+                                           _mm_mullo_epi16(r, _mm_set1_epi16(-43)),
+                                           _mm_mullo_epi16(g, _mm_set1_epi16(-85))),
+                _mm_slli_epi16(b, 7));
+            __m128i cr = _mm_add_epi16(_mm_add_epi16(
+                                           _mm_slli_epi16(r, 7),
+                                           _mm_mullo_epi16(g, _mm_set1_epi16(-107))),
+                _mm_mullo_epi16(b, _mm_set1_epi16(-21)));
+            cb = _mm_add_epi16(_mm_srai_epi16(cb, 8), bias);
+            cr = _mm_add_epi16(_mm_srai_epi16(cr, 8), bias);
+            _mm_storel_epi64((__m128i*)(u + x), _mm_packus_epi16(cb, cb));
+            _mm_storel_epi64((__m128i*)(v + x), _mm_packus_epi16(cr, cr));
+        }
+#endif
+
+        for (; x < width / 2; x++) {
+            int r_sum = 0, g_sum = 0, b_sum = 0;
+
+            for (int i = 0; i < 4; i++) {
+                uint16_t p = (i < 2 ? row0 : row1)[x * 2 + (i & 1)];
+                int r = (p >> 11) & 0x1F;
+                int g = (p >> 5) & 0x3F;
+                int b = p & 0x1F;
+                r = (r << 3) | (r >> 2);
+                g = (g << 2) | (g >> 4);
+                b = (b << 3) | (b >> 2);
+
+                (i < 2 ? y0 : y1)[x * 2 + (i & 1)] = gba_record_y(r, g, b);
+                r_sum += r;
+                g_sum += g;
+                b_sum += b;
+            }
+
+            int r = (r_sum + 2) >> 2;
+            int g = (g_sum + 2) >> 2;
+            int b = (b_sum + 2) >> 2;
+            u[x] = gba_record_u(r, g, b);
+            v[x] = gba_record_v(r, g, b);
+        }
+    }
+}
+
+static void gba_record_put_le(uint8_t* buf, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        buf[i] = (value >> (i * 8)) & 0xFF;
+    }
+}
+
+static bool gba_record_write_wav_header(FILE* fp, uint32_t sample_rate, uint32_t data_size)
+{
+    uint8_t header[GBA_RECORD_WAV_HEADER_SIZE];
+    const uint32_t channels = 2;
+    const uint32_t block_align = channels * sizeof(int16_t);
+
+    memcpy(header, "RIFF", 4);
+    gba_record_put_le(header + 4, data_size + GBA_RECORD_WAV_HEADER_SIZE - 8, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    gba_record_put_le(header + 16, 16, 4);
+    gba_record_put_le(header + 20, 1, 2); /* PCM */
+    gba_record_put_le(header + 22, channels, 2);
+    gba_record_put_le(header + 24, sample_rate, 4);
+    gba_record_put_le(header + 28, sample_rate * block_align, 4);
+    gba_record_put_le(header + 32, block_align, 2);
+    gba_record_put_le(header + 34, 16, 2);
+    memcpy(header + 36, "data", 4);
+    gba_record_put_le(header + 40, data_size, 4);
+
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+}
+
+static void gba_record_job_cb(void* user_data)
+{
+    gba_record_slot_t* slot = user_data;
+    gba_record_t* record = slot->record;
+
+    /* Jobs run in submission order on the single worker thread */
+    if (record->failed) {
+        return;
+    }
+
+    if (record->video_fp) {
+        size_t yuv_size = record->width * record->height * 3 / 2;
+        uint64_t start = gba_tick_us_get();
+        gba_record_convert(slot->yuv, slot->pixels, record->width, record->height);
+        record->convert_us += gba_tick_us_get() - start;
+        record->converted++;
+
+        for (uint32_t i = 0; i <= slot->repeat; i++) {
+            if (fwrite("FRAME\n", 1, 6, record->video_fp) != 6
+                || fwrite(slot->yuv, 1, yuv_size, record->video_fp) != yuv_size) {
+                record->failed = true;
+                return;
+            }
+            record->written++;
+        }
+    }
+
+    if (record->audio_fp && slot->audio_frames > 0) {
+        size_t size = slot->audio_frames * 2 * sizeof(int16_t);
+        if (fwrite(slot->audio, 1, size, record->audio_fp) != size) {
+            record->failed = true;
+            return;
+        }
+        record->audio_bytes += size;
+    }
+}
+
+static bool gba_record_open_video(gba_record_t* record, const char* path, double fps)
+{
+    if (path[0] == '|') {
+        /* An encoder that exits early must fail the write, not kill the process */
+        signal(SIGPIPE, SIG_IGN);
+        record->video_fp = popen(path + 1, "w");
+        record->video_pipe = true;
+    } else {
+        record->video_fp = fopen(path, "wb");
+    }
+
+    if (!record->video_fp) {
+        LV_LOG_ERROR("record: open video %s failed", path);
+        return false;
+    }
+
+    int ret = fprintf(record->video_fp, "YUV4MPEG2 W%" LV_PRIu32 " H%" LV_PRIu32 " F%" LV_PRIu32 ":1000 Ip A1:1 C420jpeg\n",
+        record->width, record->height, (uint32_t)(fps * 1000 + 0.5));
+    return ret > 0;
+}
+
+static bool gba_record_open_audio(gba_record_t* record, const char* path)
+{
+    record->audio_fp = fopen(path, "wb");
+    if (!record->audio_fp) {
+        LV_LOG_ERROR("record: open audio %s failed", path);
+        return false;
+    }
+
+    /* The sizes are patched when the recording stops */
+    return gba_record_write_wav_header(record->audio_fp, record->sample_rate, 0);
+}
+
+static void gba_record_close(gba_record_t* record)
+{
+    if (record->video_fp) {
+        if (record->video_pipe) {
+            pclose(record->video_fp);
+        } else {
+            fclose(record->video_fp);
+        }
+    }
+
+    if (record->audio_fp) {
+        if (fseek(record->audio_fp, 0, SEEK_SET) != 0
+            || !gba_record_write_wav_header(record->audio_fp, record->sample_rate, (uint32_t)record->audio_bytes)) {
+            LV_LOG_WARN("record: WAV header update failed");
+        }
+        fclose(record->audio_fp);
+    }
+
+    for (int i = 0; i < GBA_RECORD_SLOT_NUM; i++) {
+        gba_record_slot_t* slot = &record->slots[i];
+        gba_mem_free(slot->pixels);
+        gba_mem_free(slot->yuv);
+        gba_mem_free(slot->audio);
+    }
+
+    gba_mem_free(record->audio);
+    gba_mem_free(record);
+}
+
+static void gba_record_commit(gba_context_t* ctx, gba_record_slot_t* slot)
+{
+    gba_record_t* record = ctx->record;
+
+    if (slot->pixels) {
+        for (uint32_t y = 0; y < record->height; y++) {
+            lv_memcpy(slot->pixels + y * record->width,
+                ctx->frame + y * ctx->av_info.fb_stride,
+                record->width * sizeof(uint16_t));
+        }
+    }
+
+    if (slot->audio) {
+        lv_memcpy(slot->audio, record->audio, record->audio_frames * 2 * sizeof(int16_t));
+    }
+
+    slot->audio_frames = record->audio_frames;
+    slot->repeat = record->repeat_pending;
+
+    /* Same as a busy slot: the audio stays buffered and the next frame is repeated */
+    if (!gba_worker_submit(&slot->job)) {
+        record->stat.dropped++;
+        record->repeat_pending++;
+        return;
+    }
+
+    record->audio_frames = 0;
+    record->repeat_pending = 0;
+    record->slot_index = (record->slot_index + 1) % GBA_RECORD_SLOT_NUM;
+}
+
+bool gba_record_start(gba_context_t* ctx, const char* video_path, const char* audio_path)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_record_stop(ctx);
+
+    if (!video_path && !audio_path) {
+        return false;
+    }
+
+    gba_record_t* record = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_RECORD, sizeof(gba_record_t));
+    LV_ASSERT_MALLOC(record);
+
+    record->width = ctx->av_info.fb_width & ~1;
+    record->height = ctx->av_info.fb_height & ~1;
+    record->sample_rate = (uint32_t)ctx->av_info.sample_rate;
+
+    /* Everything is allocated up front, a frame only costs a copy */
+    bool ok = true;
+    size_t audio_size = GBA_RECORD_AUDIO_FRAMES_MAX * 2 * sizeof(int16_t);
+    record->audio = gba_mem_alloc(LV_GBA_MEM_TAG_RECORD, audio_size);
+    ok = ok && record->audio;
+
+    for (int i = 0; i < GBA_RECORD_SLOT_NUM; i++) {
+        gba_record_slot_t* slot = &record->slots[i];
+        slot->record = record;
+        gba_worker_job_init(&slot->job, gba_record_job_cb, slot);
+
+        if (video_path) {
+            slot->pixels = gba_mem_alloc(LV_GBA_MEM_TAG_RECORD, record->width * record->height * sizeof(uint16_t));
+            slot->yuv = gba_mem_alloc(LV_GBA_MEM_TAG_RECORD, record->width * record->height * 3 / 2);
+            ok = ok && slot->pixels && slot->yuv;
+        }
+
+        if (audio_path) {
+            slot->audio = gba_mem_alloc(LV_GBA_MEM_TAG_RECORD, audio_size);
+            ok = ok && slot->audio;
+        }
+    }
+
+    if (!ok) {
+        LV_LOG_ERROR("record: out of memory");
+        gba_record_close(record);
+        return false;
+    }
+
+    if ((video_path && !gba_record_open_video(record, video_path, ctx->av_info.fps))
+        || (audio_path && !gba_record_open_audio(record, audio_path))) {
+        gba_record_close(record);
+        return false;
+    }
+
+    ctx->record = record;
+    LV_LOG_USER("record: video %s, audio %s, %d slots",
+        video_path ? video_path : "off", audio_path ? audio_path : "off", GBA_RECORD_SLOT_NUM);
+    return true;
+}
+
+void gba_record_stop(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_record_t* record = ctx->record;
+
+    if (!record) {
+        return;
+    }
+
+    /* Frames dropped at the end still count for the length of the video */
+    if (record->repeat_pending > 0 && ctx->frame) {
+        gba_record_slot_t* slot = &record->slots[record->slot_index];
+        gba_worker_wait(&slot->job);
+        record->repeat_pending--;
+        gba_record_commit(ctx, slot);
+    }
+
+    ctx->record = NULL;
+
+    for (int i = 0; i < GBA_RECORD_SLOT_NUM; i++) {
+        gba_worker_wait(&record->slots[i].job);
+    }
+
+    if (record->failed) {
+        LV_LOG_ERROR("record: write failed, the recording is truncated");
+    }
+
+    LV_LOG_USER("record: %" LV_PRIu32 " frames, %" LV_PRIu32 " written, %" LV_PRIu32 " dropped, "
+                "%" LV_PRIu32 " audio frames dropped, convert %" LV_PRIu32 " us/frame",
+        record->stat.frames, record->written, record->stat.dropped, record->stat.audio_dropped,
+        record->converted ? (uint32_t)(record->convert_us / record->converted) : 0);
+
+    gba_record_close(record);
+}
+
+void gba_record_audio(gba_context_t* ctx, const int16_t* data, size_t frames)
+{
+    gba_record_t* record = ctx->record;
+
+    if (!record || !record->audio_fp) {
+        return;
+    }
+
+    size_t space = GBA_RECORD_AUDIO_FRAMES_MAX - record->audio_frames;
+    if (frames > space) {
+        record->stat.audio_dropped += frames - space;
+        frames = space;
+    }
+
+    lv_memcpy(record->audio + record->audio_frames * 2, data, frames * 2 * sizeof(int16_t));
+    record->audio_frames += frames;
+}
+
+void gba_record_frame(gba_context_t* ctx)
+{
+    gba_record_t* record = ctx->record;
+
+    if (!record || !ctx->frame) {
+        return;
+    }
+
+    record->stat.frames++;
+    gba_record_slot_t* slot = &record->slots[record->slot_index];
+
+    /* Never wait for the worker: the frame is dropped and the next one repeated */
+    if (gba_worker_is_busy(&slot->job)) {
+        record->stat.dropped++;
+        record->repeat_pending++;
+        return;
+    }
+
+    gba_record_commit(ctx, slot);
+}
@@ -30,7 +30,12 @@
 #define GBA_FRAME_SKIP "0"
 #endif
 
-static gba_context_t* gba_ctx_p = NULL;
+/*
+ * vba-next keeps the whole machine in globals, so a process holds a single
+ * core. The libretro callbacks take no user data and reach the instance that
+ * owns the core through this pointer; other instances are refused.
+ */
+static gba_context_t* g_core_owner = NULL;
 
 static void retro_log_printf_cb(enum retro_log_level level, const char* fmt, ...)
 {
@@ -90,7 +95,13 @@ static bool retro_environment_cb(unsigned cmd, void* data)
 
 static void retro_video_refresh_cb(const void* data, unsigned width, unsigned height, size_t pitch)
 {
-    gba_view_draw_frame(gba_ctx_p, data, width, height);
+    gba_context_t* ctx = g_core_owner;
+    ctx->frame = data;
+
+    /* Headless instances (batch runner) have no view */
+    if (ctx->view) {
+        gba_view_draw_frame(ctx, data, width, height);
+    }
 }
 
 static void retro_audio_sample_cb(int16_t left, int16_t right)
@@ -99,45 +110,101 @@ static void retro_audio_sample_cb(int16_t left, int16_t right)
 
 static size_t retro_audio_sample_batch_cb(const int16_t* data, size_t frames)
 {
-    if (!gba_ctx_p->audio_output_cb) {
+    gba_context_t* ctx = g_core_owner;
+    gba_record_audio(ctx, data, frames);
+
+    if (!ctx->audio_output_cb) {
         return 0;
     }
-    return gba_ctx_p->audio_output_cb(gba_ctx_p->audio_output_user_data, data, frames);
+    return ctx->audio_output_cb(ctx->audio_output_user_data, data, frames);
+}
+
+static void gba_retro_hotkey_handler(gba_context_t* ctx)
+{
+    /*
+     * Hotkeys are combos with SELECT held:
+     * R save, L load, UP/DOWN change slot, hold LEFT to rewind.
+     */
+    bool select = ctx->key_state & (1 << GBA_JOYPAD_SELECT);
+    ctx->rewind_active = select && (ctx->key_state & (1 << GBA_JOYPAD_LEFT));
+
+    if (!select) {
+        return;
+    }
+
+    uint32_t pressed = ctx->key_state & ~ctx->key_state_prev;
+
+    if (pressed & (1 << GBA_JOYPAD_R)) {
+        ctx->state_req = GBA_STATE_REQ_SAVE;
+    } else if (pressed & (1 << GBA_JOYPAD_L)) {
+        ctx->state_req = GBA_STATE_REQ_LOAD;
+    } else if (pressed & (1 << GBA_JOYPAD_UP)) {
+        ctx->state_slot = (ctx->state_slot + 1) % GBA_STATE_SLOT_NUM;
+        LV_LOG_USER("state slot: %d", ctx->state_slot);
+    } else if (pressed & (1 << GBA_JOYPAD_DOWN)) {
+        ctx->state_slot = (ctx->state_slot + GBA_STATE_SLOT_NUM - 1) % GBA_STATE_SLOT_NUM;
+        LV_LOG_USER("state slot: %d", ctx->state_slot);
+    } else if (!ctx->rewind_active) {
+        return;
+    }
+
+    /* Do not treat a SELECT combo as the long press to exit */
+    ctx->hotkey_used = true;
 }
 
 static void retro_input_poll_cb(void)
 {
-    gba_ctx_p->key_state = 0;
+    gba_context_t* ctx = g_core_owner;
+
+    ctx->key_state = 0;
     gba_input_event_t* input_event;
-    _LV_LL_READ(&gba_ctx_p->input_event_ll, input_event)
+    _LV_LL_READ(&ctx->input_event_ll, input_event)
     {
         uint32_t key_state = input_event->read_cb(input_event->user_data);
-        gba_ctx_p->key_state |= key_state;
+        ctx->key_state |= key_state;
     }
 
-    if (gba_ctx_p->key_state & (1 << GBA_JOYPAD_SELECT)) {
-        if (gba_ctx_p->select_press_tick == 0) {
-            gba_ctx_p->select_press_tick = lv_tick_get();
-        } else if (lv_tick_elaps(gba_ctx_p->select_press_tick) > 2000) {
-            if (gba_ctx_p->exit_cb) {
-                gba_ctx_p->exit_cb(gba_ctx_p->exit_cb_user_data);
-                gba_ctx_p->select_press_tick = 0;
+    gba_retro_hotkey_handler(ctx);
+
+    if (ctx->key_state & (1 << GBA_JOYPAD_SELECT)) {
+        if (ctx->select_press_tick == 0) {
+            ctx->select_press_tick = lv_tick_get();
+        } else if (!ctx->hotkey_used && lv_tick_elaps(ctx->select_press_tick) > 2000) {
+            if (ctx->exit_cb) {
+                ctx->exit_cb(ctx->exit_cb_user_data);
+                ctx->select_press_tick = 0;
             }
         }
     } else {
-        gba_ctx_p->select_press_tick = 0;
+        ctx->select_press_tick = 0;
+        ctx->hotkey_used = false;
     }
+
+    ctx->key_state_prev = ctx->key_state;
 }
 
 static int16_t retro_input_state_cb(unsigned port, unsigned device, unsigned index, unsigned id)
 {
-    return gba_ctx_p->key_state & (1 << id);
+    return g_core_owner->key_state & (1 << id);
+}
+
+bool gba_retro_is_busy(void)
+{
+    return g_core_owner != NULL;
 }
 
-void gba_retro_init(gba_context_t* ctx)
+bool gba_retro_init(gba_context_t* ctx)
 {
-    LV_ASSERT_MSG(gba_ctx_p == NULL, "Multi-instance mode is not supported");
-    gba_ctx_p = ctx;
+    LV_ASSERT_NULL(ctx);
+
+    /* Checked in release builds too: a second owner would steal the callbacks */
+    if (g_core_owner != NULL) {
+        LV_LOG_ERROR("the core is already used by another instance");
+        return false;
+    }
+
+    g_core_owner = ctx;
+    gba_arena_init();
     retro_set_environment(retro_environment_cb);
     retro_set_video_refresh(retro_video_refresh_cb);
     retro_set_audio_sample(retro_audio_sample_cb);
@@ -153,14 +220,18 @@ void gba_retro_init(gba_context_t* ctx)
     ctx->av_info.fb_stride = GBA_FB_STRIDE;
     ctx->av_info.fps = av_info.timing.fps;
     ctx->av_info.sample_rate = av_info.timing.sample_rate;
+    return true;
 }
 
 void gba_retro_deinit(gba_context_t* ctx)
 {
-    LV_ASSERT_NULL(gba_ctx_p);
+    LV_ASSERT(g_core_owner == ctx);
     retro_unload_game();
     retro_deinit();
-    gba_ctx_p = NULL;
+
+    /* Whatever the core left behind goes with the arena */
+    gba_arena_reset();
+    g_core_owner = NULL;
 }
 
 bool gba_retro_load_game(gba_context_t* ctx, const char* path)
@@ -171,9 +242,45 @@ bool gba_retro_load_game(gba_context_t* ctx, const char* path)
     return retro_load_game(&info);
 }
 
+void gba_retro_unload_game(gba_context_t* ctx)
+{
+    LV_ASSERT(g_core_owner == ctx);
+
+    /*
+     * The core only releases its regions in retro_deinit(), and sizes the
+     * ROM buffer in retro_init(). Stop it here without touching the arena,
+     * gba_retro_restart() starts it again once the next ROM is open.
+     */
+    retro_unload_game();
+    retro_deinit();
+}
+
+void gba_retro_restart(gba_context_t* ctx)
+{
+    LV_ASSERT(g_core_owner == ctx);
+
+    /* The regions come back from the arena pages the previous game touched */
+    retro_init();
+}
+
 void gba_retro_run(gba_context_t* ctx)
 {
+    gba_rewind_update(ctx);
     retro_run();
+
+    if (ctx->frame_cnt++ == 0) {
+        LV_LOG_USER("First frame: %" LV_PRIu32 " ms after launch, %" LV_PRIu32 " ms after ROM selected",
+            gba_uptime_ms_get(), (uint32_t)((gba_tick_us_get() - ctx->create_tick) / 1000));
+
+        /* Every region has been touched by now */
+        gba_arena_report();
+        gba_rom_report();
+    }
+
+    gba_record_frame(ctx);
+    gba_rom_update();
+    gba_autosave_update(ctx);
+    gba_state_update(ctx);
 #if THREADED_RENDERER
     if (ctx->invalidate) {
         gba_view_invalidate_frame(ctx);
@@ -182,15 +289,22 @@ void gba_retro_run(gba_context_t* ctx)
 #endif
 }
 
-static void gba_retro_get_save_path(char* save_path, size_t len, const char* rom_path)
+void gba_retro_get_file_path(char* path, size_t len, const char* rom_path, const char* ext)
 {
-    strncpy(save_path, rom_path, len - 1);
-    char* ext = strrchr(save_path, '.');
-    if (ext) {
-        strncpy(ext, ".sav", 5);
-    } else {
-        strncat(save_path, ".sav", len - strlen(save_path) - 1);
+    char base[256];
+    lv_strlcpy(base, rom_path, sizeof(base));
+
+    char* dot = strrchr(base, '.');
+    if (dot && !strchr(dot, '/')) {
+        *dot = '\0';
     }
+
+    lv_snprintf(path, len, "%s%s", base, ext);
+}
+
+void gba_retro_get_save_path(char* save_path, size_t len, const char* rom_path)
+{
+    gba_retro_get_file_path(save_path, len, rom_path, ".sav");
 }
 
 void gba_retro_save_game(gba_context_t* ctx)
@@ -205,21 +319,13 @@ void gba_retro_save_game(gba_context_t* ctx)
     char save_path[256];
     gba_retro_get_save_path(save_path, sizeof(save_path), ctx->rom_path);
 
-    lv_fs_file_t file;
-    lv_fs_res_t res = lv_fs_open(&file, save_path, LV_FS_MODE_WR);
-    if (res != LV_FS_RES_OK) {
-        LV_LOG_ERROR("save game open %s failed: %d", save_path, res);
-        return;
-    }
-
-    uint32_t bw;
-    res = lv_fs_write(&file, data, size, &bw);
-    lv_fs_close(&file);
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), save_path);
 
-    if (res != LV_FS_RES_OK || bw != size) {
-        LV_LOG_ERROR("save game write failed: %d", res);
+    if (!gba_fs_write_file_atomic(native_path, data, size)) {
+        LV_LOG_ERROR("save game write %s failed", native_path);
     } else {
-        LV_LOG_USER("Saved game to %s", save_path);
+        LV_LOG_USER("Saved game to %s", native_path);
     }
 }
 
@@ -0,0 +1,322 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include "libretro.h"
+
+/* Average size of a compressed delta used to size the entry index */
+#define GBA_REWIND_ENTRY_SIZE_HINT 256
+#define GBA_REWIND_REPORT_CAPTURES 300
+
+typedef struct {
+    uint32_t offset;
+    uint32_t size;
+} gba_rewind_entry_t;
+
+struct gba_rewind_s {
+    /* Byte ring of compressed deltas, each entry is S(n) ^ S(n - 1) */
+    uint8_t* ring;
+    size_t ring_size;
+
+    /* Entry index, oldest first */
+    gba_rewind_entry_t* entries;
+    uint32_t entry_cap;
+    uint32_t entry_head;
+    uint32_t entry_cnt;
+
+    /* Latest full state, the deltas are applied backwards from it */
+    uint8_t* cur;
+    uint8_t* tmp;
+    uint8_t* comp;
+    size_t comp_size;
+    size_t state_size;
+    bool has_cur;
+
+    uint32_t interval;
+    uint32_t frame_cnt;
+
+    struct {
+        uint64_t capture_us;
+        uint64_t bytes;
+        uint32_t captures;
+        uint32_t steps;
+    } stat;
+};
+
+static inline gba_rewind_entry_t* gba_rewind_entry(gba_rewind_t* rewind, uint32_t index)
+{
+    return &rewind->entries[(rewind->entry_head + index) % rewind->entry_cap];
+}
+
+static void gba_rewind_drop_oldest(gba_rewind_t* rewind)
+{
+    rewind->entry_head = (rewind->entry_head + 1) % rewind->entry_cap;
+    rewind->entry_cnt--;
+}
+
+static bool gba_rewind_push(gba_rewind_t* rewind, const uint8_t* data, uint32_t size)
+{
+    if (size > rewind->ring_size) {
+        return false;
+    }
+
+    uint32_t offset = 0;
+
+    if (rewind->entry_cnt > 0) {
+        gba_rewind_entry_t* newest = gba_rewind_entry(rewind, rewind->entry_cnt - 1);
+        uint32_t newest_end = newest->offset + newest->size;
+        offset = newest_end;
+
+        if (offset + size > rewind->ring_size) {
+            /* Wrap around: everything stored behind the newest entry is the oldest history */
+            while (rewind->entry_cnt > 0 && gba_rewind_entry(rewind, 0)->offset >= newest_end) {
+                gba_rewind_drop_oldest(rewind);
+            }
+            offset = 0;
+        }
+    }
+
+    while (rewind->entry_cnt > 0) {
+        gba_rewind_entry_t* oldest = gba_rewind_entry(rewind, 0);
+        bool overlap = oldest->offset < offset + size && offset < oldest->offset + oldest->size;
+        if (!overlap && rewind->entry_cnt < rewind->entry_cap) {
+            break;
+        }
+        gba_rewind_drop_oldest(rewind);
+    }
+
+    gba_rewind_entry_t* entry = gba_rewind_entry(rewind, rewind->entry_cnt);
+    entry->offset = offset;
+    entry->size = size;
+    lv_memcpy(rewind->ring + offset, data, size);
+    rewind->entry_cnt++;
+    return true;
+}
+
+static void gba_rewind_xor(uint8_t* dst, const uint8_t* src, size_t size)
+{
+    uint32_t* dst32 = (uint32_t*)dst;
+    const uint32_t* src32 = (const uint32_t*)src;
+    size_t words = size / sizeof(uint32_t);
+
+    for (size_t i = 0; i < words; i++) {
+        dst32[i] ^= src32[i];
+    }
+
+    for (size_t i = words * sizeof(uint32_t); i < size; i++) {
+        dst[i] ^= src[i];
+    }
+}
+
+static void gba_rewind_report(gba_context_t* ctx)
+{
+    gba_rewind_t* rewind = ctx->rewind;
+    if (rewind->stat.captures == 0) {
+        return;
+    }
+
+    uint32_t capture_us = rewind->stat.capture_us / rewind->stat.captures;
+    uint32_t entry_size = rewind->stat.bytes / rewind->stat.captures;
+    double sec_per_mb = entry_size
+        ? (1024.0 * 1024.0 / entry_size) * rewind->interval / ctx->av_info.fps
+        : 0;
+    double history_sec = (double)rewind->entry_cnt * rewind->interval / ctx->av_info.fps;
+
+    LV_LOG_USER("rewind: capture %" LV_PRIu32 " us (%" LV_PRIu32 " us/frame), "
+                "delta %" LV_PRIu32 " bytes, %d s/MB, history %d s (%" LV_PRIu32 " entries)",
+        capture_us, capture_us / rewind->interval, entry_size,
+        (int)sec_per_mb, (int)history_sec, rewind->entry_cnt);
+}
+
+static void gba_rewind_capture(gba_context_t* ctx)
+{
+    gba_rewind_t* rewind = ctx->rewind;
+    uint64_t start = gba_tick_us_get();
+
+    if (!retro_serialize(rewind->tmp, rewind->state_size)) {
+        return;
+    }
+
+    if (!rewind->has_cur) {
+        lv_memcpy(rewind->cur, rewind->tmp, rewind->state_size);
+        rewind->has_cur = true;
+        return;
+    }
+
+    /* tmp = S(n) ^ S(n - 1), cur = S(n) */
+    gba_rewind_xor(rewind->cur, rewind->tmp, rewind->state_size);
+    uint8_t* delta = rewind->cur;
+    rewind->cur = rewind->tmp;
+    rewind->tmp = delta;
+
+    size_t size = gba_lz_compress(rewind->tmp, rewind->state_size, rewind->comp, rewind->comp_size);
+    if (size == 0 || !gba_rewind_push(rewind, rewind->comp, size)) {
+        /* The chain is broken, restart the history from this state */
+        LV_LOG_WARN("rewind: delta does not fit, history cleared");
+        rewind->entry_cnt = 0;
+        return;
+    }
+
+    rewind->stat.capture_us += gba_tick_us_get() - start;
+    rewind->stat.bytes += size;
+    rewind->stat.captures++;
+
+    if (rewind->stat.captures % GBA_REWIND_REPORT_CAPTURES == 0) {
+        gba_rewind_report(ctx);
+    }
+}
+
+static bool gba_rewind_step(gba_context_t* ctx)
+{
+    gba_rewind_t* rewind = ctx->rewind;
+
+    if (rewind->entry_cnt == 0) {
+        return false;
+    }
+
+    gba_rewind_entry_t* newest = gba_rewind_entry(rewind, rewind->entry_cnt - 1);
+    size_t size = gba_lz_decompress(rewind->ring + newest->offset, newest->size, rewind->tmp, rewind->state_size);
+    rewind->entry_cnt--;
+
+    if (size != rewind->state_size) {
+        LV_LOG_ERROR("rewind: corrupted delta, history cleared");
+        rewind->entry_cnt = 0;
+        return false;
+    }
+
+    /* S(n - 1) = S(n) ^ delta */
+    gba_rewind_xor(rewind->cur, rewind->tmp, rewind->state_size);
+    rewind->stat.steps++;
+    return retro_unserialize(rewind->cur, rewind->state_size);
+}
+
+bool gba_rewind_init(gba_context_t* ctx, size_t budget, uint32_t interval)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_rewind_deinit(ctx);
+
+    if (budget == 0) {
+        return true;
+    }
+
+    size_t state_size = retro_serialize_size();
+    if (state_size == 0) {
+        LV_LOG_WARN("core does not support save states, rewind disabled");
+        return false;
+    }
+
+    /* The budget covers the working buffers as well as the history */
+    size_t comp_size = gba_lz_compress_bound(state_size);
+    size_t overhead = state_size * 2 + comp_size;
+    if (budget < overhead + state_size) {
+        LV_LOG_WARN("rewind budget %zu is too small, need at least %zu bytes",
+            budget, overhead + state_size);
+        return false;
+    }
+
+    gba_rewind_t* rewind = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, sizeof(gba_rewind_t));
+    LV_ASSERT_MALLOC(rewind);
+    lv_memzero(rewind, sizeof(gba_rewind_t));
+
+    rewind->state_size = state_size;
+    rewind->comp_size = comp_size;
+    rewind->interval = interval > 0 ? interval : 1;
+    rewind->ring_size = budget - overhead;
+    rewind->entry_cap = rewind->ring_size / GBA_REWIND_ENTRY_SIZE_HINT + 1;
+
+    rewind->cur = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, state_size);
+    rewind->tmp = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, state_size);
+    rewind->comp = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, comp_size);
+    rewind->ring = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, rewind->ring_size);
+    rewind->entries = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, rewind->entry_cap * sizeof(gba_rewind_entry_t));
+
+    ctx->rewind = rewind;
+
+    if (!rewind->cur || !rewind->tmp || !rewind->comp || !rewind->ring || !rewind->entries) {
+        LV_LOG_ERROR("rewind: out of memory");
+        gba_rewind_deinit(ctx);
+        return false;
+    }
+
+    LV_LOG_USER("rewind: budget %zu bytes, ring %zu bytes, state %zu bytes, interval %" LV_PRIu32 " frames",
+        budget, rewind->ring_size, state_size, rewind->interval);
+    return true;
+}
+
+void gba_rewind_deinit(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_rewind_t* rewind = ctx->rewind;
+
+    if (!rewind) {
+        return;
+    }
+
+    gba_rewind_report(ctx);
+
+    gba_mem_free(rewind->entries);
+    gba_mem_free(rewind->ring);
+    gba_mem_free(rewind->comp);
+    gba_mem_free(rewind->tmp);
+    gba_mem_free(rewind->cur);
+    gba_mem_free(rewind);
+    ctx->rewind = NULL;
+}
+
+void gba_rewind_reset(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_rewind_t* rewind = ctx->rewind;
+
+    if (!rewind) {
+        return;
+    }
+
+    /* The buffers fit any game of this core, only the history is dropped */
+    gba_rewind_report(ctx);
+    rewind->entry_head = 0;
+    rewind->entry_cnt = 0;
+    rewind->has_cur = false;
+    rewind->frame_cnt = 0;
+    lv_memzero(&rewind->stat, sizeof(rewind->stat));
+}
+
+void gba_rewind_update(gba_context_t* ctx)
+{
+    gba_rewind_t* rewind = ctx->rewind;
+
+    if (!rewind) {
+        return;
+    }
+
+    if (ctx->rewind_active) {
+        /* Restart the capture period once the rewind ends */
+        rewind->frame_cnt = 0;
+        gba_rewind_step(ctx);
+        return;
+    }
+
+    if (++rewind->frame_cnt >= rewind->interval) {
+        rewind->frame_cnt = 0;
+        gba_rewind_capture(ctx);
+    }
+}
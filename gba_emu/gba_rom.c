@@ -0,0 +1,423 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+
+#ifndef GBA_ROM_USE_MMAP
+#define GBA_ROM_USE_MMAP 1
+#endif
+
+/*
+ * Smaller ROMs are read normally: they load instantly anyway and their
+ * size could collide with the work RAM buffers of the core.
+ */
+#define GBA_ROM_MAP_MIN_SIZE (1024 * 1024)
+
+/* Frames between two demand paging reports, ~10 s */
+#define GBA_ROM_PAGING_REPORT_PERIOD 600
+
+/* Ask for huge pages on a fully mapped ROM, the core fetches code from it every cycle */
+#ifndef GBA_ROM_USE_HUGEPAGE
+#define GBA_ROM_USE_HUGEPAGE 1
+#endif
+
+#define GBA_ROM_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+#if GBA_ROM_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    char path[256];
+    size_t size;
+    uint8_t* map;
+    size_t map_size;
+    bool claimed;
+    size_t mapped_bytes;
+
+    /* Demand paging statistics */
+    bool paged;
+    unsigned char* resident_vec; /* mincore() of the previous report */
+    size_t read_in_pages;
+    uint32_t report_cnt;
+} gba_rom_t;
+
+static gba_rom_t g_rom;
+static bool g_demand_paging;
+
+static bool gba_rom_get_size(const char* path, size_t* size)
+{
+    lv_fs_file_t file;
+    lv_fs_res_t res = lv_fs_open(&file, path, LV_FS_MODE_RD);
+    if (res != LV_FS_RES_OK) {
+        LV_LOG_ERROR("open %s failed: %d", path, res);
+        return false;
+    }
+
+    lv_fs_seek(&file, 0, LV_FS_SEEK_END);
+
+    uint32_t pos;
+    res = lv_fs_tell(&file, &pos);
+    lv_fs_close(&file);
+
+    if (res != LV_FS_RES_OK) {
+        LV_LOG_ERROR("get file size failed: %d", res);
+        return false;
+    }
+
+    *size = pos;
+    return true;
+}
+
+#if GBA_ROM_USE_MMAP
+
+void* gba_rom_mmap(int fd, size_t size, int prot)
+{
+    /*
+     * The page cache can only be mapped with huge pages at a 2 MB aligned
+     * address, reserve one extra huge page and place the file inside.
+     */
+    size_t len = size + GBA_ROM_HUGE_PAGE_SIZE;
+    uint8_t* reserve = mmap(NULL, len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserve == MAP_FAILED) {
+        return NULL;
+    }
+
+    uint8_t* base = (uint8_t*)(((uintptr_t)reserve + GBA_ROM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(GBA_ROM_HUGE_PAGE_SIZE - 1));
+    void* map = mmap(base, size, prot, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (map == MAP_FAILED) {
+        munmap(reserve, len);
+        return NULL;
+    }
+
+    /* Keep only the pages of the file */
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    uint8_t* map_end = base + ((size + page_size - 1) & ~(page_size - 1));
+    if (base > reserve) {
+        munmap(reserve, base - reserve);
+    }
+    if (reserve + len > map_end) {
+        munmap(map_end, reserve + len - map_end);
+    }
+
+    return map;
+}
+
+static size_t gba_rom_get_page_num(gba_rom_t* rom)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    return (rom->map_size + page_size - 1) / page_size;
+}
+
+static bool gba_rom_map(gba_rom_t* rom)
+{
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), rom->path);
+
+    int fd = open(native_path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+
+    rom->size = st.st_size;
+
+    if (rom->size < GBA_ROM_MAP_MIN_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    /*
+     * A private mapping shares the page cache with every other process
+     * running the same ROM, a write from the core only copies that page.
+     */
+    void* map = gba_rom_mmap(fd, rom->size, PROT_READ | PROT_WRITE);
+    close(fd);
+
+    if (!map) {
+        LV_LOG_WARN("mmap %s failed, fall back to buffered read", native_path);
+        return false;
+    }
+
+    rom->map = map;
+    rom->map_size = rom->size;
+
+    /*
+     * Every mapped ROM is already paged on demand, this mode only turns the
+     * read-ahead off. A fault then brings in only the page that is touched,
+     * the resident set follows the working set, and the kernel drops cold
+     * clean pages under memory pressure and reads them back on the next access.
+     */
+    if (g_demand_paging) {
+        if (madvise(map, rom->map_size, MADV_RANDOM) != 0) {
+            LV_LOG_WARN("madvise failed, ROM pages use default read-ahead");
+        }
+        rom->paged = true;
+        rom->read_in_pages = 0;
+
+        /* Baseline: pages another process or an earlier run left in the page cache */
+        size_t page_num = gba_rom_get_page_num(rom);
+        rom->resident_vec = gba_mem_alloc(LV_GBA_MEM_TAG_IO, page_num);
+        if (rom->resident_vec && mincore(map, rom->map_size, rom->resident_vec) != 0) {
+            lv_memzero(rom->resident_vec, page_num);
+        }
+    } else if (gba_rom_want_hugepage(rom->path, rom->size)) {
+        /*
+         * Demand paging above stays on 4 KB pages to keep the resident set
+         * small. Here the whole ROM is read anyway: the page cache fills it
+         * with 2 MB folios when the filesystem supports large folios
+         * (ext4, xfs, tmpfs on recent kernels). The others ignore the hint.
+         */
+        if (madvise(map, rom->map_size, MADV_HUGEPAGE) != 0) {
+            LV_LOG_WARN("MADV_HUGEPAGE not supported, ROM uses 4 KB pages");
+        }
+    }
+
+    return true;
+}
+
+static void gba_rom_paging_report(gba_rom_t* rom)
+{
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t page_num = gba_rom_get_page_num(rom);
+
+    unsigned char* vec = gba_mem_alloc(LV_GBA_MEM_TAG_IO, page_num);
+    LV_ASSERT_MALLOC(vec);
+    if (!vec || !rom->resident_vec) {
+        gba_mem_free(vec);
+        return;
+    }
+
+    if (mincore(rom->map, rom->map_size, vec) != 0) {
+        gba_mem_free(vec);
+        return;
+    }
+
+    /*
+     * A ROM page that became resident since the last report was read from
+     * storage. A page dropped and read back within one period counts once,
+     * so this is a lower bound on the ROM misses. Hits are not counted: an
+     * access to a resident page never enters the kernel, observing it would
+     * mean trapping every access (mprotect or userfaultfd).
+     */
+    size_t resident = 0;
+    for (size_t i = 0; i < page_num; i++) {
+        resident += vec[i] & 1;
+        rom->read_in_pages += (vec[i] & 1) && !(rom->resident_vec[i] & 1);
+    }
+
+    gba_mem_free(rom->resident_vec);
+    rom->resident_vec = vec;
+
+    LV_LOG_USER("ROM paging: %zu / %zu pages resident (%zu KB), %zu pages read in (misses, at least)",
+        resident, page_num, resident * page_size / 1024, rom->read_in_pages);
+}
+
+static void gba_rom_unmap(gba_rom_t* rom)
+{
+    if (rom->map) {
+        munmap(rom->map, rom->map_size);
+        rom->map = NULL;
+        rom->map_size = 0;
+    }
+
+    if (rom->resident_vec) {
+        gba_mem_free(rom->resident_vec);
+        rom->resident_vec = NULL;
+    }
+    rom->claimed = false;
+}
+
+#else
+
+void* gba_rom_mmap(int fd, size_t size, int prot)
+{
+    return NULL;
+}
+
+static bool gba_rom_map(gba_rom_t* rom)
+{
+    return false;
+}
+
+static void gba_rom_paging_report(gba_rom_t* rom)
+{
+}
+
+static void gba_rom_unmap(gba_rom_t* rom)
+{
+}
+
+#endif
+
+bool gba_rom_open(const char* path)
+{
+    LV_ASSERT_NULL(path);
+    gba_rom_close();
+
+    gba_rom_t* rom = &g_rom;
+    lv_strlcpy(rom->path, path, sizeof(rom->path));
+
+    bool compressed = gba_archive_is_supported(path);
+    bool mapped = false;
+
+    if (compressed) {
+        /* Decompressed straight into the core buffer by the VFS, it can not be paged */
+        if (g_demand_paging) {
+            LV_LOG_WARN("demand paging is not available for compressed ROMs");
+        }
+
+        if (!gba_archive_get_size(path, &rom->size)) {
+            return false;
+        }
+    } else {
+        /* The mapping also gives the size without opening the file a second time */
+        mapped = gba_rom_map(rom);
+
+        if (!mapped && !gba_rom_get_size(path, &rom->size)) {
+            return false;
+        }
+    }
+
+    void gba_set_rom_size(int size);
+    gba_set_rom_size(rom->size);
+    LV_LOG_USER("ROM: %s size = %zu Bytes, %s", path, rom->size,
+        compressed ? "compressed" : (rom->paged ? "demand paged" : (mapped ? "mapped" : "buffered")));
+    return true;
+}
+
+void gba_rom_close(void)
+{
+    gba_rom_t* rom = &g_rom;
+
+    if (rom->paged && rom->map) {
+        gba_rom_paging_report(rom);
+    }
+
+    if (rom->mapped_bytes > 0) {
+        LV_LOG_USER("ROM: %zu bytes loaded without copy", rom->mapped_bytes);
+    }
+
+    gba_rom_unmap(rom);
+    lv_memzero(rom, sizeof(gba_rom_t));
+}
+
+bool gba_rom_want_hugepage(const char* path, size_t size)
+{
+    /* Only a ROM that is mapped whole, compressed ones are decoded into the arena */
+#if GBA_ROM_USE_MMAP && GBA_ROM_USE_HUGEPAGE && defined(MADV_HUGEPAGE)
+    return !g_demand_paging && size >= GBA_ROM_MAP_MIN_SIZE && !gba_archive_is_supported(path);
+#else
+    return false;
+#endif
+}
+
+void gba_rom_set_demand_paging(bool en)
+{
+    g_demand_paging = en;
+}
+
+void gba_rom_update(void)
+{
+    gba_rom_t* rom = &g_rom;
+
+    if (!rom->paged || !rom->map) {
+        return;
+    }
+
+    if (++rom->report_cnt >= GBA_ROM_PAGING_REPORT_PERIOD) {
+        rom->report_cnt = 0;
+        gba_rom_paging_report(rom);
+    }
+}
+
+void gba_rom_report(void)
+{
+#if GBA_ROM_USE_MMAP
+    gba_rom_t* rom = &g_rom;
+
+    if (!rom->map || rom->paged) {
+        return;
+    }
+
+    /* A ROM already in the page cache keeps the folios it was read into */
+    size_t huge_kb = gba_smaps_get_kb(rom->map, rom->map_size, "FilePmdMapped");
+    size_t rss_kb = gba_smaps_get_kb(rom->map, rom->map_size, "Rss");
+    LV_LOG_USER("ROM: %" LV_PRIu32 " KB resident, %" LV_PRIu32 " huge pages",
+        (uint32_t)rss_kb, (uint32_t)(huge_kb * 1024 / GBA_ROM_HUGE_PAGE_SIZE));
+#endif
+}
+
+bool gba_rom_is_file(const char* path)
+{
+    return g_rom.path[0] != '\0' && lv_strcmp(g_rom.path, path) == 0;
+}
+
+void* gba_rom_claim_buffer(size_t size)
+{
+    gba_rom_t* rom = &g_rom;
+
+    /* Only hand out the mapping for the allocation that is exactly the ROM buffer */
+    if (!rom->map || rom->claimed || size != rom->size) {
+        return NULL;
+    }
+
+    rom->claimed = true;
+    return rom->map;
+}
+
+bool gba_rom_release_buffer(void* ptr)
+{
+    gba_rom_t* rom = &g_rom;
+
+    if (!rom->claimed || ptr != rom->map) {
+        return false;
+    }
+
+    gba_rom_unmap(rom);
+    return true;
+}
+
+int64_t gba_rom_read_mapped(const void* dst, uint64_t pos, uint64_t len)
+{
+    gba_rom_t* rom = &g_rom;
+
+    /* The destination already holds the file content at this offset */
+    if (!rom->claimed || pos > rom->size || dst != rom->map + pos) {
+        return -1;
+    }
+
+    if (len > rom->size - pos) {
+        len = rom->size - pos;
+    }
+
+    rom->mapped_bytes += len;
+    return len;
+}
@@ -0,0 +1,312 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Incremental search over the ROM library.
+ * Names are normalized to lowercase letters and digits, so case, spaces and
+ * punctuation do not matter, and a query matches any part of the file name
+ * or the header title.
+ * A trigram index narrows a query down to the entries that contain its
+ * rarest trigram, and a query that extends the previous one only filters
+ * the previous results, so typing one more character is cheap.
+ */
+
+#define GBA_SEARCH_ALPHABET_SIZE 36
+#define GBA_SEARCH_TRIGRAM_NUM (GBA_SEARCH_ALPHABET_SIZE * GBA_SEARCH_ALPHABET_SIZE * GBA_SEARCH_ALPHABET_SIZE)
+
+/* Between the file name and the title, never part of a query or a trigram */
+#define GBA_SEARCH_SEPARATOR '|'
+
+struct gba_search_s {
+    /* Normalized names in library order */
+    char* names;
+    uint32_t* name_offsets;
+    uint32_t entry_num;
+
+    /* Entries containing each trigram, ascending. Not built past 16 bit entry numbers */
+    uint32_t* trigram_start;
+    uint16_t* postings;
+
+    /* Last query and its results, in library order */
+    char query[GBA_SEARCH_QUERY_MAX];
+    uint32_t* results;
+    uint32_t* scratch;
+    uint32_t result_num;
+};
+
+static int gba_search_char_index(char c)
+{
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    }
+    if (c >= '0' && c <= '9') {
+        return 26 + c - '0';
+    }
+    return -1;
+}
+
+static size_t gba_search_normalize(char* dst, size_t len, const char* src, size_t src_len)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < src_len && src[i] != '\0' && n + 1 < len; i++) {
+        char c = src[i];
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+        if (gba_search_char_index(c) >= 0) {
+            dst[n++] = c;
+        }
+    }
+    dst[n] = '\0';
+    return n;
+}
+
+static int32_t gba_search_trigram(const char* s)
+{
+    int a = gba_search_char_index(s[0]);
+    int b = a < 0 ? -1 : gba_search_char_index(s[1]);
+    int c = b < 0 ? -1 : gba_search_char_index(s[2]);
+    if (c < 0) {
+        return -1;
+    }
+    return (a * GBA_SEARCH_ALPHABET_SIZE + b) * GBA_SEARCH_ALPHABET_SIZE + c;
+}
+
+static void gba_search_free(gba_search_t* search)
+{
+    gba_mem_free(search->names);
+    gba_mem_free(search->name_offsets);
+    gba_mem_free(search->trigram_start);
+    gba_mem_free(search->postings);
+    gba_mem_free(search->results);
+    gba_mem_free(search->scratch);
+    lv_memzero(search, sizeof(gba_search_t));
+}
+
+static bool gba_search_build_names(gba_search_t* search, gba_library_t* library)
+{
+    uint32_t entry_num = gba_library_get_count(library);
+    const size_t name_max = sizeof(((gba_library_entry_t*)0)->path) + sizeof(((gba_library_entry_t*)0)->title) + 1;
+
+    search->name_offsets = gba_mem_alloc(LV_GBA_MEM_TAG_MENU, LV_MAX(entry_num, 1) * sizeof(uint32_t));
+    search->results = gba_mem_alloc(LV_GBA_MEM_TAG_MENU, LV_MAX(entry_num, 1) * sizeof(uint32_t));
+    search->scratch = gba_mem_alloc(LV_GBA_MEM_TAG_MENU, LV_MAX(entry_num, 1) * sizeof(uint32_t));
+    if (!search->name_offsets || !search->results || !search->scratch) {
+        return false;
+    }
+
+    size_t pool_size = 0;
+    size_t pool_cap = 0;
+
+    for (uint32_t i = 0; i < entry_num; i++) {
+        const gba_library_entry_t* entry = gba_library_get_entry(library, i);
+
+        if (pool_size + name_max > pool_cap) {
+            size_t new_cap = LV_MAX(pool_cap * 2, 4096);
+            char* names = gba_mem_realloc(LV_GBA_MEM_TAG_MENU, search->names, new_cap);
+            if (!names) {
+                return false;
+            }
+            search->names = names;
+            pool_cap = new_cap;
+        }
+
+        /* The file name without folders and extension, then the title */
+        const char* base = strrchr(entry->path, '/');
+        base = base ? base + 1 : entry->path;
+        const char* ext = strrchr(base, '.');
+        size_t base_len = ext ? (size_t)(ext - base) : strlen(base);
+
+        char* name = search->names + pool_size;
+        size_t len = gba_search_normalize(name, name_max, base, base_len);
+        name[len++] = GBA_SEARCH_SEPARATOR;
+        len += gba_search_normalize(name + len, name_max - len, entry->title, sizeof(entry->title));
+
+        search->name_offsets[i] = pool_size;
+        pool_size += len + 1;
+    }
+
+    search->entry_num = entry_num;
+    return true;
+}
+
+static bool gba_search_build_index(gba_search_t* search)
+{
+    if (search->entry_num > UINT16_MAX) {
+        return false;
+    }
+
+    search->trigram_start = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_MENU, (GBA_SEARCH_TRIGRAM_NUM + 1) * sizeof(uint32_t));
+    uint32_t* last = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_MENU, GBA_SEARCH_TRIGRAM_NUM * sizeof(uint32_t));
+    if (!search->trigram_start || !last) {
+        gba_mem_free(last);
+        return false;
+    }
+
+    /* Counted first so the postings are one array; "last" drops repeats within a name */
+    uint32_t* count = search->trigram_start + 1;
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < search->entry_num; i++) {
+        const char* name = search->names + search->name_offsets[i];
+        for (; name[0] && name[1] && name[2]; name++) {
+            int32_t id = gba_search_trigram(name);
+            if (id >= 0 && last[id] != i + 1) {
+                last[id] = i + 1;
+                count[id]++;
+                total++;
+            }
+        }
+    }
+
+    search->postings = gba_mem_alloc(LV_GBA_MEM_TAG_MENU, LV_MAX(total, 1) * sizeof(uint16_t));
+    if (!search->postings) {
+        gba_mem_free(last);
+        return false;
+    }
+
+    /* Prefix sums, "last" becomes the fill position */
+    for (uint32_t id = 0; id < GBA_SEARCH_TRIGRAM_NUM; id++) {
+        search->trigram_start[id + 1] += search->trigram_start[id];
+        last[id] = search->trigram_start[id];
+    }
+
+    for (uint32_t i = 0; i < search->entry_num; i++) {
+        const char* name = search->names + search->name_offsets[i];
+        for (; name[0] && name[1] && name[2]; name++) {
+            int32_t id = gba_search_trigram(name);
+            if (id < 0) {
+                continue;
+            }
+
+            uint32_t pos = last[id];
+            if (pos > search->trigram_start[id] && search->postings[pos - 1] == i) {
+                continue;
+            }
+            search->postings[pos] = i;
+            last[id] = pos + 1;
+        }
+    }
+
+    gba_mem_free(last);
+    return true;
+}
+
+gba_search_t* gba_search_create(void)
+{
+    gba_search_t* search = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_MENU, sizeof(gba_search_t));
+    LV_ASSERT_MALLOC(search);
+    return search;
+}
+
+void gba_search_delete(gba_search_t* search)
+{
+    if (!search) {
+        return;
+    }
+
+    gba_search_free(search);
+    gba_mem_free(search);
+}
+
+bool gba_search_build(gba_search_t* search, gba_library_t* library)
+{
+    LV_ASSERT_NULL(search);
+    LV_ASSERT_NULL(library);
+
+    uint64_t start = gba_tick_us_get();
+    gba_search_free(search);
+
+    if (!gba_search_build_names(search, library)) {
+        LV_LOG_WARN("search: out of memory");
+        gba_search_free(search);
+        return false;
+    }
+
+    /* Without the index every query scans all names, which is still correct */
+    if (!gba_search_build_index(search)) {
+        gba_mem_free(search->trigram_start);
+        search->trigram_start = NULL;
+    }
+
+    LV_LOG_USER("search: %" LV_PRIu32 " names indexed in %" LV_PRIu32 " us, %" LV_PRIu32 " postings",
+        search->entry_num, (uint32_t)(gba_tick_us_get() - start),
+        search->trigram_start ? search->trigram_start[GBA_SEARCH_TRIGRAM_NUM] : 0);
+    return true;
+}
+
+uint32_t gba_search_query(gba_search_t* search, const char* query, const uint32_t** results)
+{
+    LV_ASSERT_NULL(search);
+    LV_ASSERT_NULL(query);
+    LV_ASSERT_NULL(results);
+
+    uint64_t start = gba_tick_us_get();
+
+    char key[GBA_SEARCH_QUERY_MAX];
+    size_t key_len = gba_search_normalize(key, sizeof(key), query, sizeof(key));
+
+    /* Candidates: the previous results, the entries of the rarest trigram, or all */
+    const uint32_t* prev = NULL;
+    const uint16_t* posting = NULL;
+    uint32_t candidate_num = search->entry_num;
+
+    if (search->query[0] != '\0' && strncmp(key, search->query, strlen(search->query)) == 0) {
+        prev = search->results;
+        candidate_num = search->result_num;
+    }
+
+    if (search->trigram_start) {
+        for (size_t i = 0; i + 3 <= key_len; i++) {
+            int32_t id = gba_search_trigram(key + i);
+            uint32_t num = search->trigram_start[id + 1] - search->trigram_start[id];
+            if (num < candidate_num) {
+                prev = NULL;
+                posting = search->postings + search->trigram_start[id];
+                candidate_num = num;
+            }
+        }
+    }
+
+    uint32_t result_num = 0;
+    for (uint32_t i = 0; i < candidate_num; i++) {
+        uint32_t index = prev ? prev[i] : posting ? posting[i] : i;
+        if (key_len == 0 || strstr(search->names + search->name_offsets[index], key)) {
+            search->scratch[result_num++] = index;
+        }
+    }
+
+    uint32_t* tmp = search->results;
+    search->results = search->scratch;
+    search->scratch = tmp;
+    search->result_num = result_num;
+    lv_strlcpy(search->query, key, sizeof(search->query));
+
+    LV_LOG_INFO("search: \"%s\": %" LV_PRIu32 " of %" LV_PRIu32 " candidates in %" LV_PRIu32 " us",
+        key, result_num, candidate_num, (uint32_t)(gba_tick_us_get() - start));
+
+    *results = search->results;
+    return result_num;
+}
@@ -0,0 +1,334 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include "libretro.h"
+
+#define GBA_STATE_MAGIC 0x53414247 /* "GBAS" */
+#define GBA_STATE_VERSION 1
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t raw_size;
+    uint32_t comp_size;
+} gba_state_header_t;
+
+struct gba_state_s {
+    gba_worker_job_t job;
+
+    /* Serialized state, shared with the core on save and load */
+    uint8_t* raw_buf;
+    size_t raw_size;
+
+    /* File image: header + compressed state */
+    uint8_t* file_buf;
+    size_t file_buf_size;
+
+    int slot;
+    char path[256];
+
+    struct {
+        volatile bool ok;
+        volatile uint32_t file_size;
+        volatile uint32_t compress_us;
+        volatile uint32_t write_us;
+        uint32_t serialize_us;
+        bool pending;
+    } result;
+};
+
+static void gba_state_job_cb(void* user_data)
+{
+    gba_state_t* state = user_data;
+    gba_state_header_t* header = (gba_state_header_t*)state->file_buf;
+    uint64_t start = gba_tick_us_get();
+
+    size_t comp_size = gba_lz_compress(
+        state->raw_buf, state->raw_size,
+        state->file_buf + sizeof(gba_state_header_t),
+        state->file_buf_size - sizeof(gba_state_header_t));
+
+    uint64_t compressed = gba_tick_us_get();
+
+    state->result.ok = false;
+    if (comp_size > 0) {
+        header->magic = GBA_STATE_MAGIC;
+        header->version = GBA_STATE_VERSION;
+        header->raw_size = state->raw_size;
+        header->comp_size = comp_size;
+
+        size_t file_size = sizeof(gba_state_header_t) + comp_size;
+        state->result.ok = gba_fs_write_file_atomic(state->path, state->file_buf, file_size);
+        state->result.file_size = file_size;
+    }
+
+    state->result.compress_us = compressed - start;
+    state->result.write_us = gba_tick_us_get() - compressed;
+}
+
+static void gba_state_check_result(gba_state_t* state)
+{
+    if (!state->result.pending) {
+        return;
+    }
+
+    state->result.pending = false;
+
+    if (!state->result.ok) {
+        LV_LOG_ERROR("save state slot %d to %s failed", state->slot, state->path);
+        return;
+    }
+
+    LV_LOG_USER("Saved state slot %d: %zu -> %" LV_PRIu32 " bytes, "
+                "serialize %" LV_PRIu32 " us, compress %" LV_PRIu32 " us, write %" LV_PRIu32 " us",
+        state->slot, state->raw_size, state->result.file_size,
+        state->result.serialize_us, state->result.compress_us, state->result.write_us);
+}
+
+static bool gba_state_alloc(gba_context_t* ctx)
+{
+    if (ctx->state) {
+        return true;
+    }
+
+    size_t raw_size = retro_serialize_size();
+    if (raw_size == 0) {
+        LV_LOG_WARN("core does not support save states");
+        return false;
+    }
+
+    gba_state_t* state = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, sizeof(gba_state_t));
+    LV_ASSERT_MALLOC(state);
+    lv_memzero(state, sizeof(gba_state_t));
+
+    state->raw_size = raw_size;
+    state->raw_buf = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, raw_size);
+    LV_ASSERT_MALLOC(state->raw_buf);
+
+    state->file_buf_size = sizeof(gba_state_header_t) + gba_lz_compress_bound(raw_size);
+    state->file_buf = gba_mem_alloc(LV_GBA_MEM_TAG_STATE, state->file_buf_size);
+    LV_ASSERT_MALLOC(state->file_buf);
+
+    gba_worker_job_init(&state->job, gba_state_job_cb, state);
+    ctx->state = state;
+    return true;
+}
+
+static void gba_state_get_path(gba_context_t* ctx, int slot, char* path, size_t len)
+{
+    char ext[16];
+    if (slot == GBA_STATE_SLOT_RESUME) {
+        lv_strlcpy(ext, ".resume", sizeof(ext));
+    } else {
+        lv_snprintf(ext, sizeof(ext), ".state%d", slot);
+    }
+    gba_retro_get_file_path(path, len, ctx->rom_path, ext);
+}
+
+void gba_state_deinit(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_state_t* state = ctx->state;
+
+    if (!state) {
+        return;
+    }
+
+    gba_worker_wait(&state->job);
+    gba_state_check_result(state);
+
+    gba_mem_free(state->file_buf);
+    gba_mem_free(state->raw_buf);
+    gba_mem_free(state);
+    ctx->state = NULL;
+}
+
+void gba_state_update(gba_context_t* ctx)
+{
+    /* Requests from the hotkeys are deferred here to stay out of retro_run() */
+    gba_state_req_t req = ctx->state_req;
+    ctx->state_req = GBA_STATE_REQ_NONE;
+
+    if (req == GBA_STATE_REQ_SAVE) {
+        gba_state_save(ctx, ctx->state_slot);
+    } else if (req == GBA_STATE_REQ_LOAD) {
+        gba_state_load(ctx, ctx->state_slot);
+    }
+
+    gba_state_t* state = ctx->state;
+
+    if (!state || !state->result.pending) {
+        return;
+    }
+
+    if (!gba_worker_is_busy(&state->job)) {
+        gba_state_check_result(state);
+    }
+}
+
+bool gba_state_save(gba_context_t* ctx, int slot)
+{
+    LV_ASSERT_NULL(ctx);
+
+    if (slot < 0 || slot > GBA_STATE_SLOT_RESUME) {
+        LV_LOG_WARN("invalid state slot: %d", slot);
+        return false;
+    }
+
+    if (!gba_state_alloc(ctx)) {
+        return false;
+    }
+
+    gba_state_t* state = ctx->state;
+
+    /* The buffers are still owned by the worker, do not stall the frame */
+    if (gba_worker_is_busy(&state->job)) {
+        LV_LOG_WARN("previous save state is still in progress, slot %d skipped", slot);
+        return false;
+    }
+
+    gba_state_check_result(state);
+
+    uint64_t start = gba_tick_us_get();
+    if (!retro_serialize(state->raw_buf, state->raw_size)) {
+        LV_LOG_ERROR("retro_serialize failed");
+        return false;
+    }
+    state->result.serialize_us = gba_tick_us_get() - start;
+
+    char path[256];
+    gba_state_get_path(ctx, slot, path, sizeof(path));
+    gba_fs_get_native_path(state->path, sizeof(state->path), path);
+    state->slot = slot;
+
+    state->result.pending = gba_worker_submit(&state->job);
+    return state->result.pending;
+}
+
+bool gba_state_load(gba_context_t* ctx, int slot)
+{
+    LV_ASSERT_NULL(ctx);
+
+    if (slot < 0 || slot > GBA_STATE_SLOT_RESUME) {
+        LV_LOG_WARN("invalid state slot: %d", slot);
+        return false;
+    }
+
+    if (!gba_state_alloc(ctx)) {
+        return false;
+    }
+
+    gba_state_t* state = ctx->state;
+
+    /* A save in flight may target the same file and owns the buffers */
+    gba_worker_wait(&state->job);
+    gba_state_check_result(state);
+
+    char path[256];
+    gba_state_get_path(ctx, slot, path, sizeof(path));
+
+    uint64_t start = gba_tick_us_get();
+
+    lv_fs_file_t file;
+    lv_fs_res_t res = lv_fs_open(&file, path, LV_FS_MODE_RD);
+    if (res != LV_FS_RES_OK) {
+        LV_LOG_USER("save state not found: %s", path);
+        return false;
+    }
+
+    gba_state_header_t header;
+    uint32_t br = 0;
+    res = lv_fs_read(&file, &header, sizeof(header), &br);
+
+    bool valid = res == LV_FS_RES_OK
+        && br == sizeof(header)
+        && header.magic == GBA_STATE_MAGIC
+        && header.version == GBA_STATE_VERSION
+        && header.raw_size == state->raw_size
+        && header.comp_size <= state->file_buf_size;
+
+    if (valid) {
+        res = lv_fs_read(&file, state->file_buf, header.comp_size, &br);
+        valid = res == LV_FS_RES_OK && br == header.comp_size;
+    }
+
+    lv_fs_close(&file);
+
+    if (!valid) {
+        LV_LOG_ERROR("save state %s is invalid or incompatible", path);
+        return false;
+    }
+
+    uint64_t read_done = gba_tick_us_get();
+
+    size_t size = gba_lz_decompress(state->file_buf, header.comp_size, state->raw_buf, state->raw_size);
+    if (size != state->raw_size) {
+        LV_LOG_ERROR("save state %s is corrupted", path);
+        return false;
+    }
+
+    uint64_t decompress_done = gba_tick_us_get();
+
+    if (!retro_unserialize(state->raw_buf, state->raw_size)) {
+        LV_LOG_ERROR("retro_unserialize failed");
+        return false;
+    }
+
+    uint64_t end = gba_tick_us_get();
+
+    LV_LOG_USER("Loaded state slot %d: read %" LV_PRIu32 " us, decompress %" LV_PRIu32 " us, "
+                "unserialize %" LV_PRIu32 " us",
+        slot,
+        (uint32_t)(read_done - start),
+        (uint32_t)(decompress_done - read_done),
+        (uint32_t)(end - decompress_done));
+    return true;
+}
+
+void gba_state_suspend(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+
+    /* Nothing was loaded */
+    if (ctx->rom_path[0] == '\0') {
+        return;
+    }
+
+    /* Unlike the hotkeys, the exit snapshot must not be skipped */
+    if (ctx->state) {
+        gba_worker_wait(&ctx->state->job);
+    }
+
+    gba_state_save(ctx, GBA_STATE_SLOT_RESUME);
+}
+
+bool gba_state_resume(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+
+    if (ctx->rom_path[0] == '\0') {
+        return false;
+    }
+
+    return gba_state_load(ctx, GBA_STATE_SLOT_RESUME);
+}
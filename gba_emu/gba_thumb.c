@@ -0,0 +1,358 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Screenshot thumbnails of the last frame before exit, shown by the menu.
+ * All thumbnails live in one fixed-layout file keyed by the ROM hash of the
+ * library, so the menu maps it once and shows a thumbnail straight from the
+ * mapping, without reading or decoding anything.
+ * The frame is downscaled on exit, hashing the ROM and writing the slot is
+ * done by the worker.
+ */
+
+#define GBA_THUMB_CACHE_NAME ".gba_thumbs.bin"
+#define GBA_THUMB_MAGIC 0x54414247 /* "GBAT" */
+#define GBA_THUMB_VERSION 1
+
+#ifndef GBA_THUMB_SLOT_NUM
+#define GBA_THUMB_SLOT_NUM 512
+#endif
+
+/* Slots a key may land in, the least recently written one is replaced */
+#define GBA_THUMB_PROBE_NUM 8
+
+#define GBA_THUMB_DATA_SIZE (GBA_THUMB_WIDTH * GBA_THUMB_HEIGHT * sizeof(uint16_t))
+#define GBA_THUMB_INDEX_OFFSET sizeof(gba_thumb_file_header_t)
+/* Page aligned, so every thumbnail starts at a fixed offset of the mapping */
+#define GBA_THUMB_DATA_OFFSET \
+    ((GBA_THUMB_INDEX_OFFSET + GBA_THUMB_SLOT_NUM * sizeof(gba_thumb_slot_t) + 4095) / 4096 * 4096)
+#define GBA_THUMB_FILE_SIZE (GBA_THUMB_DATA_OFFSET + GBA_THUMB_SLOT_NUM * GBA_THUMB_DATA_SIZE)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint16_t width;
+    uint16_t height;
+    uint32_t slot_num;
+    uint32_t clock;
+} gba_thumb_file_header_t;
+
+typedef struct {
+    uint32_t crc32; /* 0: empty */
+    uint32_t size;
+    uint32_t stamp;
+    uint32_t reserved;
+} gba_thumb_slot_t;
+
+typedef struct {
+    /* Read side, LVGL thread only */
+    char cache_dir[256];
+    uint8_t* map;
+
+    /* Write side, owned by the job while it runs */
+    gba_worker_job_t job;
+    uint16_t* pixels;
+    char rom_path[256];
+    char cache_path[300];
+    volatile bool write_ok;
+} gba_thumb_t;
+
+static gba_thumb_t g_thumb;
+
+static bool gba_thumb_header_is_valid(const gba_thumb_file_header_t* header)
+{
+    return header->magic == GBA_THUMB_MAGIC
+        && header->version == GBA_THUMB_VERSION
+        && header->width == GBA_THUMB_WIDTH
+        && header->height == GBA_THUMB_HEIGHT
+        && header->slot_num == GBA_THUMB_SLOT_NUM;
+}
+
+static uint32_t gba_thumb_probe(uint32_t crc32, uint32_t i)
+{
+    return (crc32 + i) % GBA_THUMB_SLOT_NUM;
+}
+
+static void gba_thumb_get_cache_path(char* buf, size_t len, const char* cache_dir, const char* rom_path)
+{
+    char native_path[256];
+    if (cache_dir[0] != '\0') {
+        gba_fs_get_native_path(native_path, sizeof(native_path), cache_dir);
+    } else {
+        /* Launched without the menu: next to the ROM */
+        gba_fs_get_native_path(native_path, sizeof(native_path), rom_path);
+        char* sep = strrchr(native_path, '/');
+        if (sep) {
+            *sep = '\0';
+        } else {
+            native_path[0] = '\0';
+        }
+    }
+
+    size_t dir_len = strlen(native_path);
+    while (dir_len > 1 && native_path[dir_len - 1] == '/') {
+        native_path[--dir_len] = '\0';
+    }
+
+    snprintf(buf, len, "%s/%s", dir_len ? native_path : ".", GBA_THUMB_CACHE_NAME);
+}
+
+static bool gba_thumb_hash_rom(const char* path, uint32_t* crc32, uint32_t* size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    uint8_t* buf = malloc(GBA_ROM_HASH_SIZE);
+    ssize_t len = buf && fstat(fd, &st) == 0 ? read(fd, buf, GBA_ROM_HASH_SIZE) : -1;
+    close(fd);
+
+    if (len > 0) {
+        *crc32 = gba_crc32(0, buf, len);
+        *size = st.st_size;
+    }
+
+    free(buf);
+    return len > 0;
+}
+
+static int gba_thumb_open_cache(const char* path, gba_thumb_file_header_t* header)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (pread(fd, header, sizeof(*header), 0) == sizeof(*header) && gba_thumb_header_is_valid(header)) {
+        return fd;
+    }
+
+    /* New or from another layout: start over, the unused slots stay sparse */
+    memset(header, 0, sizeof(*header));
+    header->magic = GBA_THUMB_MAGIC;
+    header->version = GBA_THUMB_VERSION;
+    header->width = GBA_THUMB_WIDTH;
+    header->height = GBA_THUMB_HEIGHT;
+    header->slot_num = GBA_THUMB_SLOT_NUM;
+
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, GBA_THUMB_FILE_SIZE) != 0
+        || pwrite(fd, header, sizeof(*header), 0) != sizeof(*header)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/* Runs on the worker thread, so only libc and POSIX calls are allowed here */
+static void gba_thumb_job_cb(void* user_data)
+{
+    gba_thumb_t* thumb = user_data;
+    thumb->write_ok = false;
+
+    uint32_t crc32;
+    uint32_t size;
+    if (!gba_thumb_hash_rom(thumb->rom_path, &crc32, &size)) {
+        return;
+    }
+
+    gba_thumb_file_header_t header;
+    int fd = gba_thumb_open_cache(thumb->cache_path, &header);
+    if (fd < 0) {
+        return;
+    }
+
+    gba_thumb_slot_t slots[GBA_THUMB_PROBE_NUM];
+    uint32_t target = 0;
+    for (uint32_t i = 0; i < GBA_THUMB_PROBE_NUM; i++) {
+        off_t offset = GBA_THUMB_INDEX_OFFSET + gba_thumb_probe(crc32, i) * sizeof(gba_thumb_slot_t);
+        if (pread(fd, &slots[i], sizeof(slots[i]), offset) != sizeof(slots[i])) {
+            memset(&slots[i], 0, sizeof(slots[i]));
+        }
+
+        if (slots[i].crc32 == crc32 && slots[i].size == size) {
+            target = i;
+            break;
+        }
+
+        if (slots[target].crc32 != 0 && (slots[i].crc32 == 0 || slots[i].stamp < slots[target].stamp)) {
+            target = i;
+        }
+    }
+
+    uint32_t slot_index = gba_thumb_probe(crc32, target);
+    gba_thumb_slot_t slot = {
+        .crc32 = crc32,
+        .size = size,
+        .stamp = ++header.clock,
+    };
+
+    /* The key is cleared while the pixels are replaced, a lookup never gets another ROM's image */
+    gba_thumb_slot_t empty = { 0 };
+    off_t slot_offset = GBA_THUMB_INDEX_OFFSET + slot_index * sizeof(gba_thumb_slot_t);
+    thumb->write_ok = pwrite(fd, &empty, sizeof(empty), slot_offset) == sizeof(empty)
+        && pwrite(fd, thumb->pixels, GBA_THUMB_DATA_SIZE, GBA_THUMB_DATA_OFFSET + slot_index * GBA_THUMB_DATA_SIZE)
+            == GBA_THUMB_DATA_SIZE
+        && pwrite(fd, &slot, sizeof(slot), slot_offset) == sizeof(slot)
+        && pwrite(fd, &header, sizeof(header), 0) == sizeof(header);
+
+    close(fd);
+}
+
+static void gba_thumb_downscale(uint16_t* dst, const uint16_t* src, uint32_t width, uint32_t height, uint32_t stride)
+{
+    uint32_t scale_x = width / GBA_THUMB_WIDTH;
+    uint32_t scale_y = height / GBA_THUMB_HEIGHT;
+    uint32_t area = scale_x * scale_y;
+
+    /* Box filter, each RGB565 channel is averaged on its own */
+    for (uint32_t y = 0; y < GBA_THUMB_HEIGHT; y++) {
+        for (uint32_t x = 0; x < GBA_THUMB_WIDTH; x++) {
+            uint32_t r = 0, g = 0, b = 0;
+            const uint16_t* p = src + y * scale_y * stride + x * scale_x;
+
+            for (uint32_t sy = 0; sy < scale_y; sy++) {
+                for (uint32_t sx = 0; sx < scale_x; sx++) {
+                    uint16_t c = p[sy * stride + sx];
+                    r += c >> 11;
+                    g += (c >> 5) & 0x3F;
+                    b += c & 0x1F;
+                }
+            }
+
+            *dst++ = (uint16_t)((r / area) << 11 | (g / area) << 5 | (b / area));
+        }
+    }
+}
+
+void gba_thumb_set_dir(const char* dir_path)
+{
+    LV_ASSERT_NULL(dir_path);
+    gba_thumb_t* thumb = &g_thumb;
+
+    if (lv_strcmp(thumb->cache_dir, dir_path) == 0) {
+        return;
+    }
+
+    if (thumb->map) {
+        munmap(thumb->map, GBA_THUMB_FILE_SIZE);
+        thumb->map = NULL;
+    }
+
+    lv_strlcpy(thumb->cache_dir, dir_path, sizeof(thumb->cache_dir));
+}
+
+void gba_thumb_capture(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_thumb_t* thumb = &g_thumb;
+
+    const uint16_t* frame = gba_view_get_frame(ctx);
+    if (!frame || ctx->frame_cnt == 0
+        || ctx->av_info.fb_width < GBA_THUMB_WIDTH || ctx->av_info.fb_height < GBA_THUMB_HEIGHT) {
+        return;
+    }
+
+    /* The previous exit may still be writing */
+    gba_worker_wait(&thumb->job);
+
+    if (!thumb->pixels) {
+        thumb->pixels = gba_mem_alloc(LV_GBA_MEM_TAG_MENU, GBA_THUMB_DATA_SIZE);
+        if (!thumb->pixels) {
+            LV_LOG_WARN("thumb: malloc failed");
+            return;
+        }
+        gba_worker_job_init(&thumb->job, gba_thumb_job_cb, thumb);
+    }
+
+    uint64_t start = gba_tick_us_get();
+    gba_thumb_downscale(thumb->pixels, frame, ctx->av_info.fb_width, ctx->av_info.fb_height, ctx->av_info.fb_stride);
+
+    gba_fs_get_native_path(thumb->rom_path, sizeof(thumb->rom_path), ctx->rom_path);
+    gba_thumb_get_cache_path(thumb->cache_path, sizeof(thumb->cache_path), thumb->cache_dir, ctx->rom_path);
+
+    if (!gba_worker_submit(&thumb->job)) {
+        LV_LOG_WARN("thumb: submit failed");
+        return;
+    }
+
+    LV_LOG_USER("thumb: captured in %" LV_PRIu32 " us, writing to %s",
+        (uint32_t)(gba_tick_us_get() - start), thumb->cache_path);
+}
+
+const uint16_t* gba_thumb_get(uint32_t crc32, uint32_t size)
+{
+    gba_thumb_t* thumb = &g_thumb;
+
+    if (crc32 == 0) {
+        return NULL;
+    }
+
+    /* Mapped on the first lookup, the first capture may create the file later */
+    if (!thumb->map) {
+        char cache_path[300];
+        gba_thumb_get_cache_path(cache_path, sizeof(cache_path), thumb->cache_dir, "");
+
+        int fd = open(cache_path, O_RDONLY);
+        if (fd < 0) {
+            return NULL;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)GBA_THUMB_FILE_SIZE) {
+            void* map = mmap(NULL, GBA_THUMB_FILE_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                if (gba_thumb_header_is_valid(map)) {
+                    thumb->map = map;
+                } else {
+                    munmap(map, GBA_THUMB_FILE_SIZE);
+                }
+            }
+        }
+        close(fd);
+
+        if (!thumb->map) {
+            return NULL;
+        }
+    }
+
+    const gba_thumb_slot_t* slots = (const gba_thumb_slot_t*)(thumb->map + GBA_THUMB_INDEX_OFFSET);
+    for (uint32_t i = 0; i < GBA_THUMB_PROBE_NUM; i++) {
+        uint32_t slot_index = gba_thumb_probe(crc32, i);
+        if (slots[slot_index].crc32 == crc32 && slots[slot_index].size == size) {
+            return (const uint16_t*)(thumb->map + GBA_THUMB_DATA_OFFSET + slot_index * GBA_THUMB_DATA_SIZE);
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,193 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if LV_USE_FS_STDIO
+#define GBA_FS_NATIVE_ROOT LV_FS_STDIO_PATH
+#elif LV_USE_FS_POSIX
+#define GBA_FS_NATIVE_ROOT LV_FS_POSIX_PATH
+#else
+#define GBA_FS_NATIVE_ROOT ""
+#endif
+
+static uint64_t g_process_start_tick;
+static uint32_t g_crc32_table[256];
+
+uint64_t gba_tick_us_get(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Runs before main() so that the startup time covers the whole process */
+__attribute__((constructor)) static void gba_uptime_init(void)
+{
+    g_process_start_tick = gba_tick_us_get();
+}
+
+uint32_t gba_uptime_ms_get(void)
+{
+    return (gba_tick_us_get() - g_process_start_tick) / 1000;
+}
+
+/* Built before any thread can use it */
+__attribute__((constructor)) static void gba_crc32_init(void)
+{
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        g_crc32_table[i] = c;
+    }
+}
+
+uint32_t gba_crc32(uint32_t crc, const void* buf, size_t len)
+{
+    const uint8_t* p = buf;
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = g_crc32_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+size_t gba_smaps_get_kb(const void* addr, size_t len, const char* field)
+{
+    FILE* fp = fopen("/proc/self/smaps", "r");
+    if (!fp) {
+        return 0;
+    }
+
+    /* Sums the field over every mapping that overlaps the range */
+    uintptr_t start = (uintptr_t)addr;
+    uintptr_t end = start + len;
+    size_t field_len = strlen(field);
+    bool inside = false;
+    size_t total_kb = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long from;
+        unsigned long to;
+        unsigned long kb;
+        if (sscanf(line, "%lx-%lx ", &from, &to) == 2) {
+            inside = from < end && to > start;
+        } else if (inside && strncmp(line, field, field_len) == 0 && line[field_len] == ':'
+            && sscanf(line + field_len + 1, "%lu", &kb) == 1) {
+            total_kb += kb;
+        }
+    }
+
+    fclose(fp);
+    return total_kb;
+}
+
+void gba_fs_get_native_path(char* buf, size_t len, const char* path)
+{
+    /* Strip the drive letter, the rest is resolved like the lv_fs driver does */
+    if (path[0] != '\0' && path[1] == ':') {
+        path += 2;
+    }
+
+    while (*path == '/') {
+        path++;
+    }
+
+    lv_snprintf(buf, len, "%s%s", GBA_FS_NATIVE_ROOT, path);
+}
+
+static bool gba_fs_write_all(int fd, const uint8_t* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t ret = write(fd, data, size);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+static void gba_fs_sync_parent_dir(const char* native_path)
+{
+    char dir_path[256];
+    snprintf(dir_path, sizeof(dir_path), "%s", native_path);
+
+    char* sep = strrchr(dir_path, '/');
+    if (sep) {
+        *sep = '\0';
+    } else {
+        snprintf(dir_path, sizeof(dir_path), ".");
+    }
+
+    int fd = open(dir_path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+
+    fsync(fd);
+    close(fd);
+}
+
+/* Called from the worker thread, so only libc and POSIX calls are allowed here */
+bool gba_fs_write_file_atomic(const char* native_path, const void* data, size_t size)
+{
+    char tmp_path[260];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", native_path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    bool ok = gba_fs_write_all(fd, data, size);
+
+    /* Make sure the data hits the storage before it replaces the old file */
+    if (ok && fsync(fd) != 0) {
+        ok = false;
+    }
+
+    if (close(fd) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp_path, native_path) != 0) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    gba_fs_sync_parent_dir(native_path);
+    return true;
+}
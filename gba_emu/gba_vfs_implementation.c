@@ -20,11 +20,247 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
  * SOFTWARE.
  */
-#include "lvgl/lvgl.h"
+#include "gba_internal.h"
 #include "vfs/vfs_implementation.h"
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Every stream owns one buffer: it holds either read-ahead data or
+ * pending writes, so small accesses from the core become large lv_fs calls.
+ */
+#ifndef GBA_VFS_BUF_SIZE
+#define GBA_VFS_BUF_SIZE (32 * 1024)
+#endif
+
+typedef struct {
+    lv_fs_file_t file;
+    gba_archive_t* archive;
+    char* path;
+    bool is_rom;
+    bool error;
+    bool last_write;
+
+    /* Logical position, position of the lv_fs handle and cached size */
+    uint32_t pos;
+    uint32_t file_pos;
+    uint32_t size;
+
+    uint8_t* buf;
+    uint32_t buf_start;
+    uint32_t buf_len;
+    bool buf_dirty;
+} gba_vfs_file_t;
+
+struct libretro_vfs_implementation_dir {
+    DIR* dir;
+    struct dirent* entry;
+    bool include_hidden;
+    char path[256];
+};
+
+static inline gba_vfs_file_t* gba_vfs_get_file(libretro_vfs_implementation_file* stream)
+{
+    return (gba_vfs_file_t*)stream->fp;
+}
+
+static bool gba_vfs_raw_seek(gba_vfs_file_t* vfs_file, uint32_t pos, bool write)
+{
+    /* stdio needs a seek whenever the direction changes */
+    if (vfs_file->file_pos == pos && vfs_file->last_write == write) {
+        return true;
+    }
+
+    if (lv_fs_seek(&vfs_file->file, pos, LV_FS_SEEK_SET) != LV_FS_RES_OK) {
+        vfs_file->error = true;
+        return false;
+    }
+
+    vfs_file->file_pos = pos;
+    vfs_file->last_write = write;
+    return true;
+}
+
+static int64_t gba_vfs_raw_read(gba_vfs_file_t* vfs_file, uint32_t pos, void* buf, uint32_t len)
+{
+    uint32_t br;
+    if (!gba_vfs_raw_seek(vfs_file, pos, false) || lv_fs_read(&vfs_file->file, buf, len, &br) != LV_FS_RES_OK) {
+        vfs_file->error = true;
+        return -1;
+    }
+
+    vfs_file->file_pos += br;
+    return br;
+}
+
+static int64_t gba_vfs_raw_write(gba_vfs_file_t* vfs_file, uint32_t pos, const void* buf, uint32_t len)
+{
+    uint32_t bw;
+    if (!gba_vfs_raw_seek(vfs_file, pos, true) || lv_fs_write(&vfs_file->file, buf, len, &bw) != LV_FS_RES_OK) {
+        vfs_file->error = true;
+        return -1;
+    }
+
+    vfs_file->file_pos += bw;
+    return bw;
+}
+
+static bool gba_vfs_buf_flush(gba_vfs_file_t* vfs_file)
+{
+    if (vfs_file->buf_dirty) {
+        int64_t bw = gba_vfs_raw_write(vfs_file, vfs_file->buf_start, vfs_file->buf, vfs_file->buf_len);
+        if (bw != vfs_file->buf_len) {
+            vfs_file->error = true;
+            return false;
+        }
+    }
+
+    vfs_file->buf_dirty = false;
+    vfs_file->buf_len = 0;
+    return true;
+}
+
+static bool gba_vfs_sync(gba_vfs_file_t* vfs_file)
+{
+    if (!gba_vfs_buf_flush(vfs_file)) {
+        return false;
+    }
+
+    /* lv_fs has no flush, a seek makes the driver write out its own buffer */
+    vfs_file->file_pos = UINT32_MAX;
+    return gba_vfs_raw_seek(vfs_file, vfs_file->pos, false);
+}
+
+static bool gba_vfs_buf_alloc(gba_vfs_file_t* vfs_file)
+{
+    if (!vfs_file->buf) {
+        vfs_file->buf = gba_mem_alloc(LV_GBA_MEM_TAG_IO, GBA_VFS_BUF_SIZE);
+        LV_ASSERT_MALLOC(vfs_file->buf);
+    }
+    return vfs_file->buf != NULL;
+}
+
+static uint32_t gba_vfs_buf_read(gba_vfs_file_t* vfs_file, uint8_t* dst, uint32_t len)
+{
+    if (vfs_file->buf_dirty
+        || vfs_file->pos < vfs_file->buf_start
+        || vfs_file->pos >= vfs_file->buf_start + vfs_file->buf_len) {
+        return 0;
+    }
+
+    uint32_t offset = vfs_file->pos - vfs_file->buf_start;
+    uint32_t n = LV_MIN(len, vfs_file->buf_len - offset);
+    lv_memcpy(dst, vfs_file->buf + offset, n);
+    vfs_file->pos += n;
+    return n;
+}
+
+static int64_t gba_vfs_file_read(gba_vfs_file_t* vfs_file, uint8_t* dst, uint32_t len)
+{
+    if (vfs_file->buf_dirty && !gba_vfs_buf_flush(vfs_file)) {
+        return -1;
+    }
+
+    if (vfs_file->pos >= vfs_file->size) {
+        return 0;
+    }
+
+    len = LV_MIN(len, vfs_file->size - vfs_file->pos);
+    uint32_t total = gba_vfs_buf_read(vfs_file, dst, len);
+
+    while (total < len) {
+        uint32_t remain = len - total;
+
+        /* Large reads go straight into the destination */
+        if (remain >= GBA_VFS_BUF_SIZE || !gba_vfs_buf_alloc(vfs_file)) {
+            int64_t br = gba_vfs_raw_read(vfs_file, vfs_file->pos, dst + total, remain);
+            if (br <= 0) {
+                return total > 0 ? (int64_t)total : br;
+            }
+            vfs_file->pos += br;
+            total += br;
+            continue;
+        }
+
+        int64_t br = gba_vfs_raw_read(vfs_file, vfs_file->pos, vfs_file->buf, GBA_VFS_BUF_SIZE);
+        if (br <= 0) {
+            vfs_file->buf_len = 0;
+            return total > 0 ? (int64_t)total : br;
+        }
+
+        vfs_file->buf_start = vfs_file->pos;
+        vfs_file->buf_len = br;
+        total += gba_vfs_buf_read(vfs_file, dst + total, remain);
+    }
+
+    return total;
+}
+
+static int64_t gba_vfs_file_write(gba_vfs_file_t* vfs_file, const uint8_t* src, uint32_t len)
+{
+    /* Append to the pending data only if the write continues it */
+    if (vfs_file->buf_dirty && vfs_file->pos != vfs_file->buf_start + vfs_file->buf_len) {
+        if (!gba_vfs_buf_flush(vfs_file)) {
+            return -1;
+        }
+    }
+
+    /* Read-ahead data would go stale */
+    if (!vfs_file->buf_dirty) {
+        vfs_file->buf_len = 0;
+    }
+
+    if (vfs_file->buf_len + len > GBA_VFS_BUF_SIZE && !gba_vfs_buf_flush(vfs_file)) {
+        return -1;
+    }
+
+    if (len >= GBA_VFS_BUF_SIZE || !gba_vfs_buf_alloc(vfs_file)) {
+        int64_t bw = gba_vfs_raw_write(vfs_file, vfs_file->pos, src, len);
+        if (bw < 0) {
+            return -1;
+        }
+        vfs_file->pos += bw;
+    } else {
+        if (!vfs_file->buf_dirty) {
+            vfs_file->buf_start = vfs_file->pos;
+        }
+        lv_memcpy(vfs_file->buf + vfs_file->buf_len, src, len);
+        vfs_file->buf_len += len;
+        vfs_file->buf_dirty = true;
+        vfs_file->pos += len;
+    }
+
+    vfs_file->size = LV_MAX(vfs_file->size, vfs_file->pos);
+    return len;
+}
+
+static libretro_vfs_implementation_file* gba_vfs_stream_create(gba_vfs_file_t* vfs_file)
+{
+    libretro_vfs_implementation_file* stream = gba_mem_alloc(LV_GBA_MEM_TAG_IO, sizeof(libretro_vfs_implementation_file));
+    LV_ASSERT_MALLOC(stream);
+    lv_memzero(stream, sizeof(libretro_vfs_implementation_file));
+    stream->fp = (FILE*)vfs_file;
+    return stream;
+}
 
 libretro_vfs_implementation_file* retro_vfs_file_open_impl(const char* path, unsigned mode, unsigned hints)
 {
+    gba_vfs_file_t* vfs_file = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_IO, sizeof(gba_vfs_file_t));
+    LV_ASSERT_MALLOC(vfs_file);
+    vfs_file->path = gba_mem_strdup(LV_GBA_MEM_TAG_IO, path);
+    vfs_file->is_rom = gba_rom_is_file(path);
+
+    /* A compressed ROM is presented to the core as its decompressed content */
+    if (mode == RETRO_VFS_FILE_ACCESS_READ && vfs_file->is_rom && gba_archive_is_supported(path)) {
+        vfs_file->archive = gba_archive_open(path);
+        if (!vfs_file->archive) {
+            goto failed;
+        }
+        return gba_vfs_stream_create(vfs_file);
+    }
+
     lv_fs_mode_t fs_mode = 0;
     if (mode & RETRO_VFS_FILE_ACCESS_READ) {
         fs_mode |= LV_FS_MODE_RD;
@@ -32,151 +268,291 @@ libretro_vfs_implementation_file* retro_vfs_file_open_impl(const char* path, uns
 
     if (mode & RETRO_VFS_FILE_ACCESS_WRITE) {
         fs_mode |= LV_FS_MODE_WR;
-    }
-
-    lv_fs_file_t file;
-    lv_fs_res_t res = lv_fs_open(&file, path, fs_mode);
 
-    if (res != LV_FS_RES_OK) {
-        return NULL;
+        /* Keep the existing content instead of truncating */
+        if (mode & RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING) {
+            fs_mode |= LV_FS_MODE_RD;
+        }
     }
 
-    libretro_vfs_implementation_file* stream = lv_malloc(sizeof(libretro_vfs_implementation_file));
-    LV_ASSERT_MALLOC(stream);
-    lv_memzero(stream, sizeof(libretro_vfs_implementation_file));
+    if (lv_fs_open(&vfs_file->file, path, fs_mode) != LV_FS_RES_OK) {
+        goto failed;
+    }
 
-    lv_fs_file_t* file_p = lv_malloc(sizeof(lv_fs_file_t));
-    LV_ASSERT_MALLOC(file_p);
-    *file_p = file;
+    /* The size is only queried once, writes keep it up to date */
+    uint32_t size = 0;
+    if (lv_fs_seek(&vfs_file->file, 0, LV_FS_SEEK_END) == LV_FS_RES_OK) {
+        lv_fs_tell(&vfs_file->file, &size);
+    }
+    lv_fs_seek(&vfs_file->file, 0, LV_FS_SEEK_SET);
+    vfs_file->size = size;
 
-    stream->fp = (FILE*)file_p;
+    return gba_vfs_stream_create(vfs_file);
 
-    return stream;
+failed:
+    gba_mem_free(vfs_file->path);
+    gba_mem_free(vfs_file);
+    return NULL;
 }
 
 int retro_vfs_file_close_impl(libretro_vfs_implementation_file* stream)
 {
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
-    lv_fs_res_t res = lv_fs_close(file_p);
-    lv_free(file_p);
-    lv_free(stream);
-    return res == LV_FS_RES_OK ? 0 : -1;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    bool ok = true;
+
+    if (vfs_file->archive) {
+        gba_archive_close(vfs_file->archive);
+    } else {
+        ok = gba_vfs_buf_flush(vfs_file);
+        ok = lv_fs_close(&vfs_file->file) == LV_FS_RES_OK && ok;
+    }
+
+    gba_mem_free(vfs_file->buf);
+    gba_mem_free(vfs_file->path);
+    gba_mem_free(vfs_file);
+    gba_mem_free(stream);
+    return ok ? 0 : -1;
 }
 
 int retro_vfs_file_error_impl(libretro_vfs_implementation_file* stream)
 {
-    return -1;
+    return gba_vfs_get_file(stream)->error ? -1 : 0;
 }
 
 int64_t retro_vfs_file_size_impl(libretro_vfs_implementation_file* stream)
 {
-    int64_t retval = -1;
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
-    lv_fs_seek(file_p, 0, LV_FS_SEEK_END);
-
-    uint32_t size;
-    if (lv_fs_tell(file_p, &size) == LV_FS_RES_OK) {
-        retval = size;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return gba_archive_size(vfs_file->archive);
     }
 
-    lv_fs_seek(file_p, 0, LV_FS_SEEK_SET);
-    return retval;
+    return vfs_file->size;
 }
 
 int64_t retro_vfs_file_truncate_impl(libretro_vfs_implementation_file* stream, int64_t length)
 {
-    return -1;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive || length < 0 || !gba_vfs_sync(vfs_file)) {
+        return -1;
+    }
+
+    /* lv_fs has no truncate, go through the native path */
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), vfs_file->path);
+    if (truncate(native_path, length) != 0) {
+        LV_LOG_WARN("truncate %s failed: %d", native_path, errno);
+        return -1;
+    }
+
+    /* The handle may still buffer the old content */
+    vfs_file->size = length;
+    vfs_file->file_pos = UINT32_MAX;
+    return 0;
 }
 
 int64_t retro_vfs_file_tell_impl(libretro_vfs_implementation_file* stream)
 {
-    int64_t retval = -1;
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
-
-    uint32_t size;
-    if (lv_fs_tell(file_p, &size) == LV_FS_RES_OK) {
-        retval = size;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return gba_archive_tell(vfs_file->archive);
     }
 
-    return retval;
+    return vfs_file->pos;
 }
 
 int64_t retro_vfs_file_seek_impl(libretro_vfs_implementation_file* stream, int64_t offset, int seek_position)
 {
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
-    lv_fs_res_t res = lv_fs_seek(file_p, offset, seek_position);
-    return res == LV_FS_RES_OK ? 0 : -1;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return gba_archive_seek(vfs_file->archive, offset, seek_position);
+    }
+
+    int64_t base;
+    switch (seek_position) {
+    case RETRO_VFS_SEEK_POSITION_START:
+        base = 0;
+        break;
+    case RETRO_VFS_SEEK_POSITION_CURRENT:
+        base = vfs_file->pos;
+        break;
+    case RETRO_VFS_SEEK_POSITION_END:
+        base = vfs_file->size;
+        break;
+    default:
+        return -1;
+    }
+
+    if (base + offset < 0 || base + offset > UINT32_MAX) {
+        return -1;
+    }
+
+    /* Only moves the logical position, the buffer stays valid */
+    vfs_file->pos = base + offset;
+    return 0;
 }
 
 int64_t retro_vfs_file_read_impl(libretro_vfs_implementation_file* stream, void* s, uint64_t len)
 {
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return gba_archive_read(vfs_file->archive, s, len);
+    }
 
-    uint32_t br;
-    lv_fs_res_t res = lv_fs_read(file_p, s, len, &br);
-    return res == LV_FS_RES_OK ? (int64_t)br : -1;
+    if (vfs_file->is_rom) {
+        /* Zero copy: the core reads the ROM into its own mapping */
+        int64_t mapped = gba_rom_read_mapped(s, vfs_file->pos, len);
+        if (mapped >= 0) {
+            vfs_file->pos += mapped;
+            return mapped;
+        }
+    }
+
+    return gba_vfs_file_read(vfs_file, s, LV_MIN(len, UINT32_MAX));
 }
 
 int64_t retro_vfs_file_write_impl(libretro_vfs_implementation_file* stream, const void* s, uint64_t len)
 {
-    lv_fs_file_t* file_p = (lv_fs_file_t*)stream->fp;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return -1;
+    }
 
-    uint32_t bw;
-    lv_fs_res_t res = lv_fs_write(file_p, s, len, &bw);
-    return res == LV_FS_RES_OK ? (int64_t)bw : -1;
+    return gba_vfs_file_write(vfs_file, s, LV_MIN(len, UINT32_MAX));
 }
 
 int retro_vfs_file_flush_impl(libretro_vfs_implementation_file* stream)
 {
-    return -1;
+    gba_vfs_file_t* vfs_file = gba_vfs_get_file(stream);
+    if (vfs_file->archive) {
+        return 0;
+    }
+
+    return gba_vfs_sync(vfs_file) ? 0 : -1;
 }
 
 int retro_vfs_file_remove_impl(const char* path)
 {
-    return -1;
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), path);
+    return remove(native_path) == 0 ? 0 : -1;
 }
 
 int retro_vfs_file_rename_impl(const char* old_path, const char* new_path)
 {
-    return -1;
+    char native_old[256];
+    char native_new[256];
+    gba_fs_get_native_path(native_old, sizeof(native_old), old_path);
+    gba_fs_get_native_path(native_new, sizeof(native_new), new_path);
+    return rename(native_old, native_new) == 0 ? 0 : -1;
 }
 
 const char* retro_vfs_file_get_path_impl(libretro_vfs_implementation_file* stream)
 {
-    return NULL;
+    return gba_vfs_get_file(stream)->path;
 }
 
 int retro_vfs_stat_impl(const char* path, int32_t* size)
 {
-    return -1;
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), path);
+
+    struct stat st;
+    if (stat(native_path, &st) != 0) {
+        return 0;
+    }
+
+    if (size) {
+        *size = (int32_t)st.st_size;
+    }
+
+    int flags = RETRO_VFS_STAT_IS_VALID;
+    if (S_ISDIR(st.st_mode)) {
+        flags |= RETRO_VFS_STAT_IS_DIRECTORY;
+    }
+    if (S_ISCHR(st.st_mode)) {
+        flags |= RETRO_VFS_STAT_IS_CHARACTER_SPECIAL;
+    }
+    return flags;
 }
 
 int retro_vfs_mkdir_impl(const char* dir)
 {
-    return -1;
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), dir);
+
+    if (mkdir(native_path, 0755) == 0) {
+        return 0;
+    }
+
+    /* -2 tells the frontend the directory is already there */
+    return errno == EEXIST ? -2 : -1;
 }
 
 libretro_vfs_implementation_dir* retro_vfs_opendir_impl(const char* dir, bool include_hidden)
 {
-    return NULL;
+    char native_path[256];
+    gba_fs_get_native_path(native_path, sizeof(native_path), dir);
+
+    DIR* d = opendir(native_path);
+    if (!d) {
+        return NULL;
+    }
+
+    libretro_vfs_implementation_dir* dirstream = gba_mem_alloc_zeroed(LV_GBA_MEM_TAG_IO, sizeof(libretro_vfs_implementation_dir));
+    LV_ASSERT_MALLOC(dirstream);
+    dirstream->dir = d;
+    dirstream->include_hidden = include_hidden;
+    lv_strlcpy(dirstream->path, native_path, sizeof(dirstream->path));
+    return dirstream;
 }
 
 bool retro_vfs_readdir_impl(libretro_vfs_implementation_dir* dirstream)
 {
+    while ((dirstream->entry = readdir(dirstream->dir)) != NULL) {
+        const char* name = dirstream->entry->d_name;
+
+        if (lv_strcmp(name, ".") == 0 || lv_strcmp(name, "..") == 0) {
+            continue;
+        }
+
+        if (name[0] == '.' && !dirstream->include_hidden) {
+            continue;
+        }
+
+        return true;
+    }
+
     return false;
 }
 
 const char* retro_vfs_dirent_get_name_impl(libretro_vfs_implementation_dir* dirstream)
 {
-    return NULL;
+    return dirstream->entry ? dirstream->entry->d_name : NULL;
 }
 
 bool retro_vfs_dirent_is_dir_impl(libretro_vfs_implementation_dir* dirstream)
 {
-    return false;
+    if (!dirstream->entry) {
+        return false;
+    }
+
+#ifdef _DIRENT_HAVE_D_TYPE
+    if (dirstream->entry->d_type != DT_UNKNOWN && dirstream->entry->d_type != DT_LNK) {
+        return dirstream->entry->d_type == DT_DIR;
+    }
+#endif
+
+    /* Some file systems do not report the type, ask for it */
+    char path[512];
+    lv_snprintf(path, sizeof(path), "%s/%s", dirstream->path, dirstream->entry->d_name);
+
+    struct stat st;
+    return stat(path, &st) == 0 && S_ISDIR(st.st_mode);
 }
 
 int retro_vfs_closedir_impl(libretro_vfs_implementation_dir* dirstream)
 {
-    return -1;
+    int ret = closedir(dirstream->dir);
+    gba_mem_free(dirstream);
+    return ret == 0 ? 0 : -1;
 }
@@ -23,14 +23,41 @@
 #include "gba_emu.h"
 #include "gba_internal.h"
 
+#define GBA_VIEW_REPORT_FRAMES 600
+
 struct gba_view_s {
     lv_obj_t* root;
+    lv_display_t* disp;
 
     struct {
+        lv_obj_t* frame;
         lv_obj_t* canvas;
         lv_draw_buf_t draw_buf;
+
+        /* Filtered copy of the core frame, same stride, only used with filters */
+        uint16_t* buf;
+        uint16_t* lut;
+
+        /* Last frame before blending, for the LCD ghosting */
+        uint16_t* prev;
+        uint32_t blend_weight;
+        bool prev_valid;
+
+        uint64_t filter_us;
+        uint32_t filter_cnt;
     } screen;
 
+    /* Render time of the display, split by keypad activity */
+    struct {
+        uint64_t start;
+        uint32_t key_state;
+        bool keypad_active;
+        uint64_t idle_us;
+        uint32_t idle_cnt;
+        uint64_t keypad_us;
+        uint32_t keypad_cnt;
+    } render;
+
     struct {
         struct {
             lv_obj_t* cont;
@@ -106,9 +133,28 @@ static uint32_t btn_read_cb(void* user_data)
     BTN_STATE_DEF(view->btn.ctrl.select, GBA_JOYPAD_SELECT);
     BTN_STATE_DEF(view->btn.ctrl.start, GBA_JOYPAD_START);
 
+    /* A press and a release both redraw the keypad */
+    if (key_state || key_state != view->render.key_state) {
+        view->render.keypad_active = true;
+    }
+    view->render.key_state = key_state;
+
     return key_state;
 }
 
+static lv_obj_t* gba_view_btn_create(lv_obj_t* par)
+{
+    lv_obj_t* btn = lv_btn_create(par);
+
+    /* Without the theme transitions a press is redrawn once, not for every animation step */
+    lv_obj_set_style_transition(btn, NULL, LV_STATE_DEFAULT);
+    lv_obj_set_style_transition(btn, NULL, LV_STATE_PRESSED);
+
+    /* Touch only: a keypad indev focusing them would press the game keys on ENTER */
+    lv_group_remove_obj(btn);
+    return btn;
+}
+
 static void btn_create(gba_context_t* ctx)
 {
     const lv_coord_t cont_size = 110;
@@ -125,7 +171,7 @@ static void btn_create(gba_context_t* ctx)
 
         lv_obj_t** btn_arr = &view->btn.dir.up;
         for (int i = 0; i < GBA_ARRAY_SIZE(btn_dir_map); i++) {
-            lv_obj_t* btn = lv_btn_create(cont);
+            lv_obj_t* btn = gba_view_btn_create(cont);
             btn_arr[i] = btn;
             lv_obj_align(btn, btn_dir_map[i].align, 0, 0);
 
@@ -146,7 +192,7 @@ static void btn_create(gba_context_t* ctx)
 
         lv_obj_t** btn_arr = &view->btn.func.A;
         for (int i = 0; i < GBA_ARRAY_SIZE(btn_func_map); i++) {
-            lv_obj_t* btn = lv_btn_create(cont);
+            lv_obj_t* btn = gba_view_btn_create(cont);
             btn_arr[i] = btn;
             lv_obj_align(btn, btn_func_map[i].align, 0, 0);
 
@@ -168,7 +214,7 @@ static void btn_create(gba_context_t* ctx)
 
         lv_obj_t** btn_arr = &view->btn.ctrl.start;
         for (int i = 0; i < GBA_ARRAY_SIZE(btn_ctrl_map); i++) {
-            lv_obj_t* btn = lv_btn_create(cont);
+            lv_obj_t* btn = gba_view_btn_create(cont);
             btn_arr[i] = btn;
             lv_obj_align(btn, btn_ctrl_map[i].align, 0, 0);
 
@@ -181,9 +227,45 @@ static void btn_create(gba_context_t* ctx)
     lv_gba_emu_add_input_read_cb(view->root, btn_read_cb, view);
 }
 
+static void render_event_cb(lv_event_t* e)
+{
+    gba_view_t* view = lv_event_get_user_data(e);
+
+    if (lv_event_get_code(e) == LV_EVENT_RENDER_START) {
+        view->render.start = gba_tick_us_get();
+        return;
+    }
+
+    uint64_t elapsed = gba_tick_us_get() - view->render.start;
+    if (view->render.keypad_active) {
+        view->render.keypad_us += elapsed;
+        view->render.keypad_cnt++;
+        view->render.keypad_active = false;
+    } else {
+        view->render.idle_us += elapsed;
+        view->render.idle_cnt++;
+    }
+
+    if (view->render.idle_cnt + view->render.keypad_cnt < GBA_VIEW_REPORT_FRAMES) {
+        return;
+    }
+
+    LV_LOG_USER("view: render %" LV_PRIu32 " us/frame (%" LV_PRIu32 " frames), "
+                "with keypad %" LV_PRIu32 " us/frame (%" LV_PRIu32 " frames)",
+        view->render.idle_cnt ? (uint32_t)(view->render.idle_us / view->render.idle_cnt) : 0,
+        view->render.idle_cnt,
+        view->render.keypad_cnt ? (uint32_t)(view->render.keypad_us / view->render.keypad_cnt) : 0,
+        view->render.keypad_cnt);
+
+    view->render.idle_us = 0;
+    view->render.idle_cnt = 0;
+    view->render.keypad_us = 0;
+    view->render.keypad_cnt = 0;
+}
+
 void gba_view_init(gba_context_t* ctx, lv_obj_t* par, int mode)
 {
-    gba_view_t* view = lv_malloc(sizeof(gba_view_t));
+    gba_view_t* view = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, sizeof(gba_view_t));
     LV_ASSERT_MALLOC(view);
     lv_memzero(view, sizeof(gba_view_t));
     ctx->view = view;
@@ -203,14 +285,30 @@ void gba_view_init(gba_context_t* ctx, lv_obj_t* par, int mode)
         lv_obj_set_flex_align(root, LV_FLEX_ALIGN_SPACE_AROUND, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_SPACE_AROUND);
     }
 
-    view->screen.canvas = lv_canvas_create(view->root);
-
-    if (mode != LV_GBA_VIEW_MODE_SIMPLE) {
-        lv_obj_t* canvas = view->screen.canvas;
-        lv_obj_set_style_outline_color(canvas, lv_theme_get_color_primary(canvas), 0);
-        lv_obj_set_style_outline_width(canvas, 5, 0);
+    /*
+     * The outline is the border of a frame behind the canvas. The canvas
+     * draws nothing outside of the image, so a new frame invalidates the
+     * image only and the keypad is never repainted with it.
+     */
+    lv_obj_t* frame = lv_obj_create(view->root);
+    {
+        view->screen.frame = frame;
+        lv_obj_remove_style_all(frame);
+        lv_obj_clear_flag(frame, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_set_size(frame, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+
+        if (mode != LV_GBA_VIEW_MODE_SIMPLE) {
+            lv_obj_set_style_border_color(frame, lv_theme_get_color_primary(frame), 0);
+            lv_obj_set_style_border_width(frame, 5, 0);
+        }
     }
 
+    view->screen.canvas = lv_canvas_create(frame);
+
+    view->disp = lv_obj_get_display(root);
+    lv_display_add_event_cb(view->disp, render_event_cb, LV_EVENT_RENDER_START, view);
+    lv_display_add_event_cb(view->disp, render_event_cb, LV_EVENT_RENDER_READY, view);
+
     if (mode == LV_GBA_VIEW_MODE_VIRTUAL_KEYPAD) {
         btn_create(ctx);
     }
@@ -220,7 +318,11 @@ void gba_view_deinit(gba_context_t* ctx)
 {
     LV_ASSERT_NULL(ctx);
     LV_ASSERT_NULL(ctx->view);
-    lv_free(ctx->view);
+    lv_display_remove_event_cb_with_user_data(ctx->view->disp, render_event_cb, ctx->view);
+    gba_mem_free(ctx->view->screen.buf);
+    gba_mem_free(ctx->view->screen.lut);
+    gba_mem_free(ctx->view->screen.prev);
+    gba_mem_free(ctx->view);
 }
 
 lv_obj_t* gba_view_get_root(gba_context_t* ctx)
@@ -234,12 +336,150 @@ void gba_view_invalidate_frame(gba_context_t* ctx)
 {
     LV_ASSERT_NULL(ctx);
     LV_ASSERT_NULL(ctx->view);
-    lv_obj_invalidate(ctx->view->screen.canvas);
+
+    /* Exactly the image, whatever the styles around it add */
+    lv_obj_t* canvas = ctx->view->screen.canvas;
+    lv_area_t area;
+    lv_obj_get_coords(canvas, &area);
+    lv_obj_invalidate_area(canvas, &area);
+}
+
+void gba_view_set_color_profile(gba_context_t* ctx, lv_gba_color_profile_t profile)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_view_t* view = ctx->view;
+    LV_ASSERT_NULL(view);
+
+    gba_mem_free(view->screen.lut);
+    view->screen.lut = gba_color_create_lut(profile);
+
+    /* The blend history is kept in the output colors */
+    view->screen.prev_valid = false;
+
+    /* Shown on the next frame */
+}
+
+void gba_view_set_frame_blend(gba_context_t* ctx, uint32_t weight)
+{
+    LV_ASSERT_NULL(ctx);
+    gba_view_t* view = ctx->view;
+    LV_ASSERT_NULL(view);
+
+    view->screen.blend_weight = LV_MIN(weight, GBA_BLEND_WEIGHT_MAX);
+    view->screen.prev_valid = false;
+
+    if (view->screen.blend_weight == 0) {
+        gba_mem_free(view->screen.prev);
+        view->screen.prev = NULL;
+    }
+}
+
+void gba_view_hide_output(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+
+    if (ctx->video_output_cb) {
+        ctx->video_output_cb(ctx->video_output_user_data, NULL, 0, 0, 0, NULL);
+    }
+}
+
+void gba_view_set_output_key(gba_context_t* ctx, bool en)
+{
+    LV_ASSERT_NULL(ctx);
+    LV_ASSERT_NULL(ctx->view);
+
+    /* The image stays set for the size and the thumbnails, only its drawing is keyed out */
+    lv_obj_t* canvas = ctx->view->screen.canvas;
+    lv_obj_set_style_image_opa(canvas, en ? LV_OPA_TRANSP : LV_OPA_COVER, 0);
+    lv_obj_set_style_bg_color(canvas, LV_GBA_EMU_VIDEO_KEY_COLOR, 0);
+    lv_obj_set_style_bg_opa(canvas, en ? LV_OPA_COVER : LV_OPA_TRANSP, 0);
+}
+
+const uint16_t* gba_view_get_frame(gba_context_t* ctx)
+{
+    LV_ASSERT_NULL(ctx);
+    LV_ASSERT_NULL(ctx->view);
+    return (const uint16_t*)ctx->view->screen.draw_buf.data;
+}
+
+static const uint16_t* gba_view_filter_frame(gba_context_t* ctx, const uint16_t* buf, lv_coord_t width, lv_coord_t height)
+{
+    gba_view_t* view = ctx->view;
+
+    const uint16_t* lut = view->screen.lut;
+    uint32_t weight = view->screen.blend_weight;
+    lv_coord_t stride = ctx->av_info.fb_stride;
+    size_t size = stride * height * sizeof(uint16_t);
+
+    /* Without filters the core buffer is shown directly */
+    if (!lut && weight == 0) {
+        if (view->screen.buf) {
+            gba_mem_free(view->screen.buf);
+            view->screen.buf = NULL;
+        }
+        return buf;
+    }
+
+    if (!view->screen.buf) {
+        view->screen.buf = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, size);
+        if (!view->screen.buf) {
+            LV_LOG_WARN("view: no memory for the filtered frame");
+            return buf;
+        }
+    }
+
+    if (weight > 0 && !view->screen.prev) {
+        view->screen.prev = gba_mem_alloc(LV_GBA_MEM_TAG_EMU, size);
+        if (!view->screen.prev) {
+            LV_LOG_WARN("view: no memory for frame blending");
+            view->screen.blend_weight = weight = 0;
+        }
+    }
+
+    uint64_t start = gba_tick_us_get();
+
+    /* The only pass over the frame, row by row so that every filter hits L1 */
+    for (lv_coord_t y = 0; y < height; y++) {
+        const uint16_t* src = buf + y * stride;
+        uint16_t* dst = view->screen.buf + y * stride;
+
+        if (lut) {
+            gba_color_apply_lut(dst, src, lut, width, 1, stride);
+            src = dst;
+        }
+
+        if (weight > 0) {
+            uint16_t* prev = view->screen.prev + y * stride;
+            if (view->screen.prev_valid) {
+                gba_blend_row(dst, prev, src, width, weight);
+            } else {
+                lv_memcpy(prev, src, width * sizeof(uint16_t));
+                if (dst != src) {
+                    lv_memcpy(dst, src, width * sizeof(uint16_t));
+                }
+            }
+        }
+    }
+
+    view->screen.prev_valid = weight > 0;
+
+    view->screen.filter_us += gba_tick_us_get() - start;
+    if (++view->screen.filter_cnt == GBA_VIEW_REPORT_FRAMES) {
+        LV_LOG_USER("view: filters %" LV_PRIu32 " us/frame (LUT %d, blend %" LV_PRIu32 "/%d)",
+            (uint32_t)(view->screen.filter_us / view->screen.filter_cnt),
+            lut != NULL, weight, GBA_BLEND_WEIGHT_MAX);
+        view->screen.filter_us = 0;
+        view->screen.filter_cnt = 0;
+    }
+
+    return view->screen.buf;
 }
 
 void gba_view_draw_frame(gba_context_t* ctx, const uint16_t* buf, lv_coord_t width, lv_coord_t height)
 {
     lv_obj_t* canvas = ctx->view->screen.canvas;
+    buf = gba_view_filter_frame(ctx, buf, width, height);
+
     if (ctx->view->screen.draw_buf.data != (uint8_t*)buf) {
         lv_draw_buf_init(
             &ctx->view->screen.draw_buf,
@@ -250,6 +490,22 @@ void gba_view_draw_frame(gba_context_t* ctx, const uint16_t* buf, lv_coord_t wid
         LV_LOG_USER("set direct canvas buffer = %p", (void*)buf);
     }
 
+    /*
+     * The port presents the frame itself below the canvas area, which LVGL
+     * draws in the key color. Nothing changes there, so it is not invalidated.
+     */
+    if (ctx->video_output_cb) {
+        if (!lv_obj_is_visible(canvas)) {
+            gba_view_hide_output(ctx);
+            return;
+        }
+
+        lv_area_t area;
+        lv_obj_get_coords(canvas, &area);
+        ctx->video_output_cb(ctx->video_output_user_data, buf, width, height, ctx->av_info.fb_stride, &area);
+        return;
+    }
+
 #if THREADED_RENDERER
     ctx->invalidate = true;
 #else
@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ * Copyright (c) 2026 _VIFEXTech
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "gba_internal.h"
+#include <pthread.h>
+
+typedef struct {
+    pthread_t thread_id;
+    pthread_mutex_t mutex;
+    pthread_cond_t job_cond;
+    pthread_cond_t done_cond;
+    gba_worker_job_t* head;
+    gba_worker_job_t* tail;
+    bool started;
+} gba_worker_t;
+
+static gba_worker_t g_worker = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .job_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void* gba_worker_thread(void* arg)
+{
+    gba_worker_t* worker = arg;
+
+    pthread_mutex_lock(&worker->mutex);
+    while (1) {
+        while (worker->head == NULL) {
+            pthread_cond_wait(&worker->job_cond, &worker->mutex);
+        }
+
+        gba_worker_job_t* job = worker->head;
+        worker->head = job->next;
+        if (worker->head == NULL) {
+            worker->tail = NULL;
+        }
+        job->next = NULL;
+
+        /* Jobs must not touch LVGL: the LVGL core is not thread safe (LV_OS_NONE) */
+        pthread_mutex_unlock(&worker->mutex);
+        job->cb(job->user_data);
+        pthread_mutex_lock(&worker->mutex);
+
+        job->busy = false;
+        pthread_cond_broadcast(&worker->done_cond);
+    }
+
+    pthread_mutex_unlock(&worker->mutex);
+    return NULL;
+}
+
+void gba_worker_job_init(gba_worker_job_t* job, gba_worker_cb_t cb, void* user_data)
+{
+    LV_ASSERT_NULL(job);
+    lv_memzero(job, sizeof(gba_worker_job_t));
+    job->cb = cb;
+    job->user_data = user_data;
+}
+
+bool gba_worker_submit(gba_worker_job_t* job)
+{
+    LV_ASSERT_NULL(job);
+    LV_ASSERT_NULL(job->cb);
+    gba_worker_t* worker = &g_worker;
+
+    pthread_mutex_lock(&worker->mutex);
+
+    if (job->busy) {
+        pthread_mutex_unlock(&worker->mutex);
+        return false;
+    }
+
+    if (!worker->started) {
+        int ret = pthread_create(&worker->thread_id, NULL, gba_worker_thread, worker);
+        if (ret != 0) {
+            pthread_mutex_unlock(&worker->mutex);
+            LV_LOG_ERROR("pthread_create failed: %d", ret);
+            return false;
+        }
+        worker->started = true;
+    }
+
+    job->busy = true;
+    job->next = NULL;
+    if (worker->tail) {
+        worker->tail->next = job;
+    } else {
+        worker->head = job;
+    }
+    worker->tail = job;
+
+    pthread_cond_signal(&worker->job_cond);
+    pthread_mutex_unlock(&worker->mutex);
+    return true;
+}
+
+bool gba_worker_is_busy(gba_worker_job_t* job)
+{
+    LV_ASSERT_NULL(job);
+    pthread_mutex_lock(&g_worker.mutex);
+    bool busy = job->busy;
+    pthread_mutex_unlock(&g_worker.mutex);
+    return busy;
+}
+
+void gba_worker_wait(gba_worker_job_t* job)
+{
+    LV_ASSERT_NULL(job);
+    pthread_mutex_lock(&g_worker.mutex);
+    while (job->busy) {
+        pthread_cond_wait(&g_worker.done_cond, &g_worker.mutex);
+    }
+    pthread_mutex_unlock(&g_worker.mutex);
+}
@@ -67,7 +67,7 @@ After=network.target systemd-user-sessions.service plymouth-quit-wait.service
 
 [Service]
 Type=simple
-ExecStart=$PROJECT_ROOT/build/$BIN_NAME -d rom
+ExecStart=$PROJECT_ROOT/build/$BIN_NAME -d rom -a
 WorkingDirectory=$PROJECT_ROOT
 Restart=no
 User=$REAL_USER
@@ -26,11 +26,13 @@
 #include "lvgl/src/misc/lv_profiler_builtin.h"
 #include "port/port.h"
 #include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
 #define GBA_EMU_PREFIX "gba_emu: "
+#define GBA_EMU_REWIND_INTERVAL 4
 
 #define OPTARG_TO_VALUE(value, type, base)                                  \
     do {                                                                    \
@@ -48,25 +50,48 @@ typedef struct
     const char* dir_path;
     lv_gba_view_mode_t mode;
     int volume;
+    int rewind_mb;
+    lv_gba_color_profile_t color_profile;
+    int blend_percent;
+    bool auto_resume;
+    bool demand_paging;
     bool skip_intro;
+    bool direct_video;
     bool enable_profiler;
     bool enable_sysmon;
+    uint32_t batch_frames;
+    int batch_jobs;
+    const char* report_path;
+    const char* record_video_path;
+    const char* record_audio_path;
 } gba_emu_param_t;
 
 static void show_usage(const char* progname, int exitcode)
 {
     printf("\nUsage: %s"
-           " -f <string> -d <string> -m <decimal-value> -v <decimal-value> -s -h\n",
-        progname);
+           " -f <string> -d <string> -m <decimal-value> -v <decimal-value> -r <decimal-value> -g <decimal-value> -t <decimal-value> -c <string> -w <string> -a -l -s -z -h\n"
+           "       %s -b <decimal-value> [-j <decimal-value>] [-o <string>] [-d <string> | -f <string>]\n",
+        progname, progname);
     printf("\nWhere:\n");
     printf("  -f <string> rom file path.\n");
     printf("  -d <string> rom directory path (default: .).\n");
     printf("  -m <decimal-value> view mode: "
            "0: simple; 1: virtual keypad.\n");
     printf("  -v <decimal-value> set volume: 0 ~ 100.\n");
+    printf("  -r <decimal-value> rewind buffer size in MB (default: 0, disabled).\n");
+    printf("  -g <decimal-value> color correction: 0: off; 1: GBA; 2: GBA SP.\n");
+    printf("  -t <decimal-value> frame blending, weight of the previous frame in %% (default: 0, disabled; 50: even mix).\n");
+    printf("  -c <string> record video to a Y4M file, or pipe it to an encoder command starting with '|'.\n");
+    printf("  -w <string> record audio to a WAV file.\n");
+    printf("  -a suspend on exit and resume on launch.\n");
+    printf("  -l map the ROM without read-ahead, report page residency (low memory).\n");
     printf("  -s skip intro animation.\n");
+    printf("  -z present frames directly with SDL, bypassing the LVGL canvas.\n");
     printf("  -p enable profiler.\n");
     printf("  -n enable system monitor.\n");
+    printf("  -b <decimal-value> batch mode: run every ROM headless for this many frames.\n");
+    printf("  -j <decimal-value> batch worker processes (default: one per CPU).\n");
+    printf("  -o <string> batch report file (default: stdout).\n");
     printf("  -h help.\n");
 
     exit(exitcode);
@@ -82,7 +107,7 @@ static void parse_commandline(int argc, char* const* argv, gba_emu_param_t* para
     param->dir_path = ".";
     param->skip_intro = false;
 
-    while ((ch = getopt(argc, argv, "f:d:m:v:spnh")) != -1) {
+    while ((ch = getopt(argc, argv, "f:d:m:v:r:g:t:c:w:alszpnb:j:o:h")) != -1) {
         switch (ch) {
         case 'f':
             param->file_path = optarg;
@@ -100,10 +125,42 @@ static void parse_commandline(int argc, char* const* argv, gba_emu_param_t* para
             OPTARG_TO_VALUE(param->volume, int, 10);
             break;
 
+        case 'r':
+            OPTARG_TO_VALUE(param->rewind_mb, int, 10);
+            break;
+
+        case 'g':
+            OPTARG_TO_VALUE(param->color_profile, lv_gba_color_profile_t, 10);
+            break;
+
+        case 't':
+            OPTARG_TO_VALUE(param->blend_percent, int, 10);
+            break;
+
+        case 'c':
+            param->record_video_path = optarg;
+            break;
+
+        case 'w':
+            param->record_audio_path = optarg;
+            break;
+
+        case 'a':
+            param->auto_resume = true;
+            break;
+
+        case 'l':
+            param->demand_paging = true;
+            break;
+
         case 's':
             param->skip_intro = true;
             break;
 
+        case 'z':
+            param->direct_video = true;
+            break;
+
         case 'p':
             param->enable_profiler = true;
             break;
@@ -112,6 +169,18 @@ static void parse_commandline(int argc, char* const* argv, gba_emu_param_t* para
             param->enable_sysmon = true;
             break;
 
+        case 'b':
+            OPTARG_TO_VALUE(param->batch_frames, uint32_t, 10);
+            break;
+
+        case 'j':
+            OPTARG_TO_VALUE(param->batch_jobs, int, 10);
+            break;
+
+        case 'o':
+            param->report_path = optarg;
+            break;
+
         case '?':
             printf(GBA_EMU_PREFIX ": Unknown option: %c\n", optopt);
         case 'h':
@@ -121,6 +190,14 @@ static void parse_commandline(int argc, char* const* argv, gba_emu_param_t* para
     }
 }
 
+static volatile sig_atomic_t g_quit = 0;
+
+static void on_signal(int sig)
+{
+    LV_UNUSED(sig);
+    g_quit = 1;
+}
+
 static void log_print_cb(lv_log_level_t level, const char* str)
 {
     LV_UNUSED(level);
@@ -129,12 +206,39 @@ static void log_print_cb(lv_log_level_t level, const char* str)
 
 static void on_rom_selected(const char* path, void* user_data);
 
+/* Hidden and paused while the menu is shown, the next ROM is loaded into it */
+static lv_obj_t* g_gba_emu = NULL;
+static lv_obj_t* g_menu = NULL;
+
+static void on_gba_emu_delete(lv_event_t* e)
+{
+    LV_UNUSED(e);
+    g_gba_emu = NULL;
+}
+
+static void on_menu_delete(lv_event_t* e)
+{
+    LV_UNUSED(e);
+    g_menu = NULL;
+}
+
+static void show_menu(gba_emu_param_t* param)
+{
+    g_menu = gba_menu_create(lv_scr_act(), param->dir_path, on_rom_selected, param);
+    lv_obj_add_event(g_menu, on_menu_delete, LV_EVENT_DELETE, NULL);
+}
+
 static void return_to_menu(void* user_data)
 {
-    gba_audio_deinit(NULL);
     gba_emu_param_t* param = (gba_emu_param_t*)user_data;
-    lv_obj_clean(lv_scr_act());
-    gba_menu_create(lv_scr_act(), param->dir_path, on_rom_selected, param);
+
+    if (g_gba_emu) {
+        /* Keep the core, the view and the audio device for the next game */
+        lv_gba_emu_set_paused(g_gba_emu, true);
+        lv_obj_add_flag(g_gba_emu, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    show_menu(param);
 }
 
 static void on_game_exit(void* user_data)
@@ -146,20 +250,66 @@ static void on_rom_selected(const char* path, void* user_data)
 {
     gba_emu_param_t* param = (gba_emu_param_t*)user_data;
 
+    if (g_gba_emu) {
+        if (g_menu) {
+            lv_obj_delete(g_menu);
+        }
+
+        lv_obj_remove_flag(g_gba_emu, LV_OBJ_FLAG_HIDDEN);
+        if (lv_gba_emu_switch_rom(g_gba_emu, path)) {
+            return;
+        }
+
+        LV_LOG_USER("switch ROM failed, restart the emulator");
+        gba_audio_deinit(NULL);
+    }
+
     lv_obj_clean(lv_scr_act());
 
     lv_obj_t* gba_emu = lv_gba_emu_create(lv_scr_act(), path, param->mode);
 
     if (!gba_emu) {
         LV_LOG_USER("create gba emu failed");
-        gba_menu_create(lv_scr_act(), param->dir_path, on_rom_selected, param);
+        show_menu(param);
         return;
     }
 
+    g_gba_emu = gba_emu;
+    lv_obj_add_event(gba_emu, on_gba_emu_delete, LV_EVENT_DELETE, NULL);
+
     lv_gba_emu_set_on_exit_cb(gba_emu, on_game_exit, param);
 
+    if (param->auto_resume) {
+        lv_gba_emu_set_auto_resume(gba_emu, true);
+    }
+
+    if (param->rewind_mb > 0) {
+        lv_gba_emu_set_rewind(gba_emu, (size_t)param->rewind_mb * 1024 * 1024, GBA_EMU_REWIND_INTERVAL);
+    }
+
+    if (param->color_profile != LV_GBA_COLOR_PROFILE_NONE) {
+        lv_gba_emu_set_color_profile(gba_emu, param->color_profile);
+    }
+
+    if (param->blend_percent > 0) {
+        lv_gba_emu_set_frame_blend(gba_emu, param->blend_percent);
+    }
+
+    /* The recording goes on across ROM switches, until the emulator is deleted */
+    if (param->record_video_path || param->record_audio_path) {
+        if (!lv_gba_emu_start_record(gba_emu, param->record_video_path, param->record_audio_path)) {
+            LV_LOG_WARN("start recording failed");
+        }
+    }
+
     gba_port_init(gba_emu);
 
+    if (param->direct_video) {
+        if (gba_video_init(gba_emu) < 0) {
+            LV_LOG_WARN("direct video init failed, using the canvas");
+        }
+    }
+
     LV_LOG_USER("volume = %d", param->volume);
     if (param->volume > 0) {
         if (gba_audio_init(gba_emu) < 0) {
@@ -178,7 +328,7 @@ static void intro_timer_cb(lv_timer_t* t)
     if (param->file_path) {
         on_rom_selected(param->file_path, param);
     } else {
-        gba_menu_create(lv_scr_act(), param->dir_path, on_rom_selected, param);
+        show_menu(param);
     }
 }
 
@@ -239,7 +389,7 @@ static void start_intro(gba_emu_param_t* param)
             return;
         }
 
-        gba_menu_create(lv_scr_act(), param->dir_path, on_rom_selected, param);
+        show_menu(param);
         return;
     }
 
@@ -260,19 +410,45 @@ int main(int argc, const char* argv[])
     lv_log_register_print_cb(log_print_cb);
 #endif
 
+    /* Exit cleanly on stop so that the game is saved and suspended */
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
     lv_init();
 
+    static gba_emu_param_t param;
+    parse_commandline(argc, (char* const*)argv, &param);
+
+    /* Headless: no display, no input and no audio */
+    if (param.batch_frames > 0) {
+        lv_gba_emu_batch_param_t batch = {
+            .dir_path = param.dir_path,
+            .file_path = param.file_path,
+            .frames = param.batch_frames,
+            .jobs = param.batch_jobs,
+            .report_path = param.report_path,
+        };
+        lv_gba_emu_set_rom_demand_paging(param.demand_paging);
+        return lv_gba_emu_run_batch(&batch) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     if (lv_port_init() < 0) {
         LV_LOG_USER("hal init failed");
         return -1;
     }
 
-    static gba_emu_param_t param;
-    parse_commandline(argc, (char* const*)argv, &param);
+    lv_gba_emu_set_rom_demand_paging(param.demand_paging);
     start_intro(&param);
 
-    while (true) {
+    while (!g_quit) {
         uint32_t sleep_ms = lv_timer_handler();
         lv_port_sleep(sleep_ms);
     }
+
+    LV_LOG_USER("exit");
+    lv_obj_clean(lv_scr_act());
+    gba_audio_deinit(NULL);
+    gba_video_deinit(NULL);
+    lv_gba_emu_dump_mem();
+    return 0;
 }
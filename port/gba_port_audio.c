@@ -82,8 +82,15 @@ static audio_ctx_t g_audio_ctx;
 int gba_audio_init(lv_obj_t* gba_emu)
 {
     int ret;
+    static bool fifo_tracked = false;
     audio_fifo_init(&g_audio_ctx.fifo, g_audio_ctx.buffer, AUDIO_FIFO_LEN);
 
+    /* Static, counted once for the whole process */
+    if (!fifo_tracked) {
+        lv_gba_emu_track_mem(LV_GBA_MEM_TAG_PORT, sizeof(g_audio_ctx.buffer));
+        fifo_tracked = true;
+    }
+
     int sample_rate = lv_gba_emu_get_audio_sample_rate(gba_emu);
     LV_ASSERT(sample_rate > 0);
     g_audio_ctx.sample_rate = sample_rate;
@@ -0,0 +1,303 @@
+/**
+ * @file gba_port_video.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+#include "../gba_emu/gba_emu.h"
+#include "port.h"
+
+#if LV_USE_SDL
+#include <SDL2/SDL.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+#define VIDEO_REPORT_FRAMES 600
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+#if LV_USE_SDL
+typedef struct {
+    lv_display_t* disp;
+    SDL_Renderer* renderer;
+
+    /* The LVGL screen, transparent where the canvas shows the key color */
+    SDL_Texture* ui_texture;
+
+    SDL_Texture* game_texture;
+    int32_t game_width;
+    int32_t game_height;
+    SDL_Rect game_rect;
+    bool game_shown;
+
+    uint64_t present_ticks;
+    uint32_t present_cnt;
+} video_ctx_t;
+#endif
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+
+#if LV_USE_SDL
+static void video_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map);
+static void video_convert_ui(uint8_t* dst, int dst_stride, const uint8_t* src, uint32_t src_stride,
+    int32_t width, int32_t height);
+static void gba_video_output_cb(void* user_data, const uint16_t* buf,
+    int32_t width, int32_t height, int32_t stride, const lv_area_t* area);
+static void video_present(video_ctx_t* ctx);
+#endif
+
+/**********************
+ *  STATIC VARIABLES
+ **********************/
+
+#if LV_USE_SDL
+static video_ctx_t g_video_ctx;
+#endif
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+
+#if LV_USE_SDL
+
+int gba_video_init(lv_obj_t* gba_emu)
+{
+    video_ctx_t* ctx = &g_video_ctx;
+
+    /* The display is taken over once, a new emulator only registers itself */
+    if (!ctx->disp) {
+        lv_display_t* disp = lv_display_get_default();
+        SDL_Renderer* renderer = disp ? lv_sdl_window_get_renderer(disp) : NULL;
+
+        if (!renderer || lv_display_get_color_format(disp) != LV_COLOR_FORMAT_RGB565) {
+            LV_LOG_WARN("direct video needs an RGB565 SDL window");
+            return -1;
+        }
+
+        SDL_Texture* texture = SDL_CreateTexture(
+            renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING,
+            lv_display_get_horizontal_resolution(disp),
+            lv_display_get_vertical_resolution(disp));
+        if (!texture) {
+            LV_LOG_ERROR("SDL_CreateTexture failed: %s", SDL_GetError());
+            return -1;
+        }
+
+        /* Blended over the game, so widgets on top of the screen stay visible */
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+        ctx->disp = disp;
+        ctx->renderer = renderer;
+        ctx->ui_texture = texture;
+
+        /*
+         * LVGL keeps rendering the widgets, the composition is done here.
+         * The window keeps this flush callback until it is closed, a later
+         * emulator registers itself again.
+         */
+        lv_display_set_flush_cb(disp, video_flush_cb);
+    }
+
+    lv_gba_emu_set_video_output_cb(gba_emu, gba_video_output_cb, ctx);
+
+    /* Fill the UI texture */
+    lv_obj_invalidate(lv_display_get_screen_active(ctx->disp));
+    return 0;
+}
+
+void gba_video_deinit(lv_obj_t* gba_emu)
+{
+    video_ctx_t* ctx = &g_video_ctx;
+
+    if (gba_emu) {
+        lv_gba_emu_set_video_output_cb(gba_emu, NULL, NULL);
+    }
+
+    if (!ctx->disp) {
+        return;
+    }
+
+    /* Without a key color on the screen the UI texture is opaque again */
+    lv_obj_invalidate(lv_display_get_screen_active(ctx->disp));
+
+    if (ctx->game_texture) {
+        SDL_DestroyTexture(ctx->game_texture);
+        ctx->game_texture = NULL;
+    }
+    ctx->game_width = 0;
+    ctx->game_height = 0;
+    ctx->game_shown = false;
+}
+
+#else
+
+int gba_video_init(lv_obj_t* gba_emu)
+{
+    LV_UNUSED(gba_emu);
+    LV_LOG_WARN("direct video is only supported on SDL");
+    return -1;
+}
+
+void gba_video_deinit(lv_obj_t* gba_emu)
+{
+    LV_UNUSED(gba_emu);
+}
+
+#endif
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+
+#if LV_USE_SDL
+
+static void video_flush_cb(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map)
+{
+    video_ctx_t* ctx = &g_video_ctx;
+    SDL_Rect rect = {
+        .x = area->x1,
+        .y = area->y1,
+        .w = lv_area_get_width(area),
+        .h = lv_area_get_height(area),
+    };
+
+    /* The window was created by lv_sdl_window_create() with this mode */
+    uint32_t src_stride = rect.w * sizeof(uint16_t);
+    if (LV_SDL_RENDER_MODE != LV_DISPLAY_RENDER_MODE_PARTIAL) {
+        src_stride = lv_draw_buf_width_to_stride(
+            lv_display_get_horizontal_resolution(disp), LV_COLOR_FORMAT_RGB565);
+        px_map += area->y1 * src_stride + area->x1 * sizeof(uint16_t);
+    }
+
+    /* Only the dirty areas are converted, the texture keeps the rest */
+    void* pixels;
+    int dst_stride;
+    if (SDL_LockTexture(ctx->ui_texture, &rect, &pixels, &dst_stride) == 0) {
+        video_convert_ui(pixels, dst_stride, px_map, src_stride, rect.w, rect.h);
+        SDL_UnlockTexture(ctx->ui_texture);
+    }
+
+    if (lv_display_flush_is_last(disp)) {
+        video_present(ctx);
+    }
+
+    lv_display_flush_ready(disp);
+}
+
+static void gba_video_output_cb(void* user_data, const uint16_t* buf,
+    int32_t width, int32_t height, int32_t stride, const lv_area_t* area)
+{
+    video_ctx_t* ctx = user_data;
+
+    if (!buf || !area) {
+        if (ctx->game_shown) {
+            ctx->game_shown = false;
+            video_present(ctx);
+        }
+        return;
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+
+    if (!ctx->game_texture || ctx->game_width != width || ctx->game_height != height) {
+        if (ctx->game_texture) {
+            SDL_DestroyTexture(ctx->game_texture);
+        }
+
+        ctx->game_texture = SDL_CreateTexture(
+            ctx->renderer,
+            SDL_PIXELFORMAT_RGB565,
+            SDL_TEXTUREACCESS_STREAMING,
+            width, height);
+        if (!ctx->game_texture) {
+            LV_LOG_ERROR("SDL_CreateTexture failed: %s", SDL_GetError());
+            return;
+        }
+
+        ctx->game_width = width;
+        ctx->game_height = height;
+    }
+
+    /* The single copy of the frame, straight from the core buffer */
+    SDL_UpdateTexture(ctx->game_texture, NULL, buf, stride * sizeof(uint16_t));
+
+    /* The UI texture covers the whole target, follow its scale */
+    int target_w, target_h;
+    SDL_RenderGetLogicalSize(ctx->renderer, &target_w, &target_h);
+    if (target_w == 0 || target_h == 0) {
+        SDL_GetRendererOutputSize(ctx->renderer, &target_w, &target_h);
+    }
+
+    int32_t hor_res = lv_display_get_horizontal_resolution(ctx->disp);
+    int32_t ver_res = lv_display_get_vertical_resolution(ctx->disp);
+    ctx->game_rect.x = area->x1 * target_w / hor_res;
+    ctx->game_rect.y = area->y1 * target_h / ver_res;
+    ctx->game_rect.w = lv_area_get_width(area) * target_w / hor_res;
+    ctx->game_rect.h = lv_area_get_height(area) * target_h / ver_res;
+    ctx->game_shown = true;
+
+    video_present(ctx);
+
+    ctx->present_ticks += SDL_GetPerformanceCounter() - start;
+    if (++ctx->present_cnt == VIDEO_REPORT_FRAMES) {
+        LV_LOG_USER("video: upload + present %" LV_PRIu32 " us/frame",
+            (uint32_t)(ctx->present_ticks * 1000000 / SDL_GetPerformanceFrequency() / ctx->present_cnt));
+        ctx->present_ticks = 0;
+        ctx->present_cnt = 0;
+    }
+}
+
+static void video_convert_ui(uint8_t* dst, int dst_stride, const uint8_t* src, uint32_t src_stride,
+    int32_t width, int32_t height)
+{
+    const uint16_t key = lv_color_to_u16(LV_GBA_EMU_VIDEO_KEY_COLOR);
+
+    for (int32_t y = 0; y < height; y++) {
+        const uint16_t* src_row = (const uint16_t*)(src + y * src_stride);
+        uint32_t* dst_row = (uint32_t*)(dst + y * dst_stride);
+
+        for (int32_t x = 0; x < width; x++) {
+            uint16_t p = src_row[x];
+            uint32_t r = (p >> 11) & 0x1F;
+            uint32_t g = (p >> 5) & 0x3F;
+            uint32_t b = p & 0x1F;
+            r = (r << 3) | (r >> 2);
+            g = (g << 2) | (g >> 4);
+            b = (b << 3) | (b >> 2);
+
+            /* The key color is a hole the game shows through */
+            dst_row[x] = p == key ? 0 : 0xFF000000 | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+static void video_present(video_ctx_t* ctx)
+{
+    SDL_RenderClear(ctx->renderer);
+
+    /* Scaled by the GPU, below the widgets */
+    if (ctx->game_shown) {
+        SDL_RenderCopy(ctx->renderer, ctx->game_texture, NULL, &ctx->game_rect);
+    }
+
+    SDL_RenderCopy(ctx->renderer, ctx->ui_texture, NULL, NULL);
+    SDL_RenderPresent(ctx->renderer);
+}
+
+#endif
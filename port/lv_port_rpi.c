@@ -10,6 +10,7 @@
 
 #if LV_USE_RPI
 
+#include "../gba_emu/gba_emu.h"
 #include "port.h"
 #include "rpi/st7789.h"
 #include "rpi/wiring_pi_port.h"
@@ -142,6 +143,7 @@ int lv_port_init(void)
         ctx.draw_buf2,
         sizeof(ctx.draw_buf1),
         LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_gba_emu_track_mem(LV_GBA_MEM_TAG_PORT, sizeof(ctx.draw_buf1) + sizeof(ctx.draw_buf2));
 
     /* Init keys */
     for (int i = 0; i < sizeof(key_map) / sizeof(key_map[0]); i++) {
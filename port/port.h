@@ -38,6 +38,9 @@ void gba_port_init(lv_obj_t* gba_emu);
 int gba_audio_init(lv_obj_t* gba_emu);
 void gba_audio_deinit(lv_obj_t* gba_emu);
 
+int gba_video_init(lv_obj_t* gba_emu);
+void gba_video_deinit(lv_obj_t* gba_emu);
+
 /**********************
  *      MACROS
  **********************/